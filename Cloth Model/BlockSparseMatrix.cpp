@@ -0,0 +1,122 @@
+#include "BlockSparseMatrix.hpp"
+
+// C/C++ Standard Libraries
+#include <algorithm>
+
+using namespace std;
+using namespace glm;
+
+BlockSparseMatrix::BlockSparseMatrix(void)
+{
+    rows = 0;
+}
+
+BlockSparseMatrix::~BlockSparseMatrix(void)
+{
+}
+
+GLvoid BlockSparseMatrix::build(GLsizei nRows, const vector<Spring>& springs) {
+
+    rows = nRows;
+
+    const GLsizei NumS = (GLsizei)springs.size();
+
+    // Every (row, column) pair, then sorted & merged, springs sharing a pair share its block
+    vector<pair<GLuint, GLuint> > entries;
+    entries.reserve(rows + (NumS * 2));
+
+    for (GLsizei i = 0; i < rows; i++)
+        entries.push_back(make_pair((GLuint)i, (GLuint)i));
+
+    for (GLsizei s = 0; s < NumS; s++) {
+
+        entries.push_back(make_pair(springs[s].particleA, springs[s].particleB));
+        entries.push_back(make_pair(springs[s].particleB, springs[s].particleA));
+    }
+
+    sort(entries.begin(), entries.end());
+    entries.erase(unique(entries.begin(), entries.end()), entries.end());
+
+    rowOffsets.assign(rows + 1, 0);
+    columns.resize(entries.size());
+    diagonal.resize(rows);
+
+    for (size_t k = 0; k < entries.size(); k++) {
+
+        rowOffsets[entries[k].first + 1]++;
+        columns[k] = entries[k].second;
+
+        if (entries[k].first == entries[k].second)
+            diagonal[entries[k].first] = (GLuint)k;
+    }
+
+    for (GLsizei i = 0; i < rows; i++)
+        rowOffsets[i + 1] += rowOffsets[i];
+
+    blocks.assign(entries.size(), mat3(0));
+
+    // Columns are sorted within each row
+    springBlocks.resize(NumS * 2);
+
+    for (GLsizei s = 0; s < NumS; s++) {
+
+        GLuint a = springs[s].particleA;
+        GLuint b = springs[s].particleB;
+
+        springBlocks[(s * 2) + 0] = (GLuint)(lower_bound(columns.begin() + rowOffsets[a], columns.begin() + rowOffsets[a + 1], b) - columns.begin());
+        springBlocks[(s * 2) + 1] = (GLuint)(lower_bound(columns.begin() + rowOffsets[b], columns.begin() + rowOffsets[b + 1], a) - columns.begin());
+    }
+}
+
+// Releases the pattern, e.g. after the particles are reordered
+GLvoid BlockSparseMatrix::clear(void) {
+
+    rows = 0;
+
+    vector<GLuint>().swap(rowOffsets);
+    vector<GLuint>().swap(columns);
+    vector<mat3>().swap(blocks);
+    vector<GLuint>().swap(diagonal);
+    vector<GLuint>().swap(springBlocks);
+}
+
+// Keeps the pattern, zeroes every block
+GLvoid BlockSparseMatrix::setZero(void) {
+
+    const GLsizei NumB = (GLsizei)blocks.size();
+
+    #pragma omp parallel for schedule(static) if (rows >= SPMV_PARALLEL_ROWS)
+    for (GLsizei k = 0; k < NumB; k++)
+        blocks[k] = mat3(0);
+}
+
+GLsizei BlockSparseMatrix::getRows(void) const {
+    return(rows);
+}
+
+GLsizei BlockSparseMatrix::getNumBlocks(void) const {
+    return((GLsizei)blocks.size());
+}
+
+GLuint BlockSparseMatrix::getDiagonal(GLsizei row) const {
+    return(diagonal[row]);
+}
+
+GLuint BlockSparseMatrix::getSpringBlock(GLsizei spring, GLuint side) const {
+    return(springBlocks[(spring * 2) + side]);
+}
+
+mat3& BlockSparseMatrix::block(GLuint k) {
+    return(blocks[k]);
+}
+
+const mat3& BlockSparseMatrix::block(GLuint k) const {
+    return(blocks[k]);
+}
+
+GLvoid BlockSparseMatrix::multiply(const vec3* x, vec3* y) const {
+
+    #pragma omp parallel for schedule(static) if (rows >= SPMV_PARALLEL_ROWS)
+    for (GLsizei i = 0; i < rows; i++)
+        y[i] = multiplyRow(i, x);
+}
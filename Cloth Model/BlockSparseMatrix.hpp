@@ -0,0 +1,123 @@
+// Header Guards
+#ifndef BLOCKSPARSEMATRIX_HPP
+#define BLOCKSPARSEMATRIX_HPP
+
+#pragma once
+
+// OpenGL Scalar Types, see GLTypes.hpp
+#include "GLTypes.hpp"
+
+// OpenGL Mathematics Library
+#include <GLM/glm.hpp>
+
+// C/C++ Standard Libraries
+#include <vector>
+
+// Internal Dependancies
+#include "LargeVM.hpp"
+#include "SpringKernel.hpp"
+
+#define SPMV_PARALLEL_ROWS 4096 // Minimum rows before a product is split across threads
+
+// Block compressed sparse row matrix of 3x3 blocks, one block row per particle
+// The sparsity pattern is built once from the spring topology, each row holds its diagonal block and one block per spring
+// neighbour, in ascending column order
+class BlockSparseMatrix {
+
+public:
+
+    BlockSparseMatrix(void);
+    ~BlockSparseMatrix(void);
+
+    // Pattern of the diagonal plus the (a, b) & (b, a) blocks of every spring, all blocks zeroed
+    GLvoid build(GLsizei rows, const std::vector<Spring>& springs);
+    GLvoid clear(void);
+    GLvoid setZero(void);
+
+    GLsizei getRows(void) const;
+    GLsizei getNumBlocks(void) const;
+
+    // Block indices, side 0 is the (particleA, particleB) block of a spring and side 1 the (particleB, particleA) block
+    GLuint getDiagonal(GLsizei row) const;
+    GLuint getSpringBlock(GLsizei spring, GLuint side) const;
+
+    glm::mat3& block(GLuint k);
+    const glm::mat3& block(GLuint k) const;
+    
+    // Blocks [getRowBegin(i), getRowEnd(i)) make up row i, getColumn(k) is the column of block k
+    inline GLuint getRowBegin(GLsizei row) const;
+    inline GLuint getRowEnd(GLsizei row) const;
+    inline GLuint getColumn(GLuint k) const;
+
+    // Row i of A x
+    inline glm::vec3 multiplyRow(GLsizei row, const glm::vec3* x) const;
+
+    // y = A x, rows are independent and split across threads
+    GLvoid multiply(const glm::vec3* x, glm::vec3* y) const;
+
+private:
+
+    GLsizei rows;
+
+    std::vector<GLuint> rowOffsets;     // Per row offsets into columns & blocks
+    std::vector<GLuint> columns;
+    std::vector<glm::mat3> blocks;
+
+    std::vector<GLuint> diagonal;       // Per row index of the diagonal block
+    std::vector<GLuint> springBlocks;   // Per spring indices of its two off-diagonal blocks
+};
+
+inline GLuint BlockSparseMatrix::getRowBegin(GLsizei row) const {
+    return(rowOffsets[row]);
+}
+
+inline GLuint BlockSparseMatrix::getRowEnd(GLsizei row) const {
+    return(rowOffsets[row + 1]);
+}
+
+inline GLuint BlockSparseMatrix::getColumn(GLuint k) const {
+    return(columns[k]);
+}
+
+inline glm::vec3 BlockSparseMatrix::multiplyRow(GLsizei row, const glm::vec3* x) const {
+
+    glm::vec3 sum = glm::vec3(0);
+
+    for (GLuint k = rowOffsets[row]; k < rowOffsets[row + 1]; k++)
+        sum += blocks[k] * x[columns[k]];
+
+    return(sum);
+}
+
+// Sparse matrix-vector product as a LargeVM expression, so r = b - (A * x) is still a single loop
+// Unlike the element-wise nodes each row reads other elements of x, so A * x must not be assigned back into x
+class LargeVMSparseProduct : public LargeVMExpr<LargeVMSparseProduct, glm::vec3> {
+
+public:
+
+    LargeVMSparseProduct(const BlockSparseMatrix& A, const LargeVM<glm::vec3>& x) : A(A), x(x) {
+
+    }
+
+    glm::vec3 operator[](GLsizei i) const {
+
+        return A.multiplyRow(i, x.data());
+    }
+
+    GLsizei size(void) const {
+
+        return A.getRows();
+    }
+
+private:
+
+    const BlockSparseMatrix& A;
+    const LargeVM<glm::vec3>& x;
+};
+
+inline LargeVMSparseProduct operator*(const BlockSparseMatrix& A, const LargeVM<glm::vec3>& x) {
+
+    return LargeVMSparseProduct(A, x);
+}
+
+#endif /* BlockSparseMatrix_hpp */
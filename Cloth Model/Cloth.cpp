@@ -1,45 +1,51 @@
 #include "Cloth.hpp"
 
-#define STRUCTURAL_SPRING 0
-#define SHEAR_SPRING 1
-#define BEND_SPRING 2
-
 #define I_OFFSET 2 * 3
 
 using namespace std;
 using namespace glm;
 
-Cloth::Cloth(GLfloat uWidth, GLfloat uHeight, GLuint nPX, GLuint nPY, enum Preset preset) : NumPX(nPX), NumPY(nPY),NumP_XY((nPX + 1) * (nPY + 1)), Gravity(vec3(0, -0.000981f, 0)), EPS(1/100.0f), IMAX(10), solverIterations(5), pset(preset)
+Cloth::Cloth(GLfloat uWidth, GLfloat uHeight, GLuint nPX, GLuint nPY, enum Preset preset) : NumPX(nPX), NumPY(nPY),NumP_XY((nPX + 1) * (nPY + 1)), Gravity(vec3(0, -0.000981f, 0)), EPS(1/1000.0f), IMAX(10), solverIterations(5), pset(preset)
 {
     
     faces.clear();
+    faceNormals.clear();
     particles.clear();
     constraints.clear();
     
-    sForce.clear(); // Sum Of Forces, Used by Runge-Kutta (RK4) Scheme
-    sVelocity.clear(); // Sum Of Velocities, Used by Runge-Kutta (RK4) Scheme
-    
-    pForce.clear(); // Predicted Forces, Used by IMplicit-Explicit (IMEX) Scheme
-    
-    dForceDX.clear(); // Partial Differential ∂F/∂X, Used by Modified Backward Euler Scheme
-    dForceDV.clear(); // Partial Differential ∂F/∂V, Used by Modified Backward Euler Scheme
-    
     particles.resize(NumP_XY);
     vertexIndices.resize((NumPX * NumPY) * I_OFFSET);
     
     // Constraint Stiffness & Damping Settings, Settings Optimised for Euler Integration Schemes
     // TODO: Global Stiffness function
     GlobalDamping = NULL;
-    KsStruct = NULL, KsShear = NULL, KsBend = NULL;
-    KdStruct = NULL, KdShear = NULL, KdBend = NULL;
     
-    drawWire = GL_FALSE;
+    SpringMaterial material = { 0.0f, 0.0f, 0.0f, 0.0f };
+    materials.assign(SPRING_TYPES, material);
+    
+    accumulation = GATHER;
+    fuseStep = GL_TRUE;
+    ordering = MORTON;
+    
     collisionFlag = GL_FALSE;
-    intersectQ = vec3(0);
     
-    VAO = NULL;
-    EBO = NULL;
-    VBO = NULL;
+    projectiveDt = 0.0f;
+    projectiveStale = GL_TRUE;
+    
+    imexDt = 0.0f;
+    
+    constraintSolver = LONG_RANGE_ATTACHMENTS;
+    constraintRadius = 0.0f;
+    jacobiRadius = 0.0f;
+    jacobiRadiusDt = 0.0f;
+    
+    SolverPolicy policy = { PCCG, RELATIVE_RESIDUAL, EPS, GL_TRUE, GL_TRUE, 0 };
+    setSolverPolicy(policy);
+    
+    StepPolicy stepping = { GL_FALSE, 1.0e-5f, 0.5f, 1.0e-5f, 1.0f, 64 };
+    setStepPolicy(stepping);
+    
+    setSpringRates(4, 4, 1);
     
     initMesh(uWidth, uHeight, NumPX, NumPY, pset);
     initExtentions();
@@ -49,105 +55,116 @@ Cloth::~Cloth(void)
 {
 }
 
-inline Particle* Cloth::getParticle(GLuint x, GLuint y) {
-    return(&particles[getParticleIndex(x, y)]);
+inline Particle Cloth::getParticle(GLuint x, GLuint y) {
+    return(Particle(&particles, getParticleIndex(x, y)));
 }
 
 inline GLuint Cloth::getParticleIndex(GLuint x, GLuint y) {
-    return((x + (y * (NumPX + 1))));
+    return(gridToParticle[x + (y * (NumPX + 1))]);
+}
+
+inline vec3 Cloth::getPolyNormal(GLuint pA, GLuint pB, GLuint pC) {
+    return(cross((particles.position[pB] - particles.position[pA]), (particles.position[pC] - particles.position[pA])));
+}
+
+inline vec3 Cloth::verletVelocity(GLuint i, GLfloat dt) {
+    return((particles.position[i] - particles.lastPosition[i]) / dt);
 }
 
-inline vec3 Cloth::getPolyNormal(Particle* pA, Particle* pB, Particle* pC) {
-    return(cross((pB->getPosition() - pA->getPosition()), (pC->getPosition() - pA->getPosition())));
+// Particle stream updates, mirroring Particle::setNewPosition & Particle::setNewVelocity
+inline GLvoid Cloth::setNewPosition(GLuint i, const vec3& X) {
+    
+    if (particles.movable[i]) {
+        particles.lastPosition[i] = particles.position[i];
+        particles.position[i] = X;
+    }
 }
 
-inline vec3 Cloth::verletVelocity(Particle& p, GLfloat dt) {
-    return((p.getPosition() - p.getLPosition()) / dt);
+inline GLvoid Cloth::setNewVelocity(GLuint i, const vec3& V) {
+    
+    particles.lastVelocity[i] = particles.velocity[i];
+    particles.velocity[i] = V;
 }
 
 inline GLfloat Cloth::randFunc(GLfloat v) {
     return((-v) + ((GLfloat)rand() / RAND_MAX) * ((v) - (-v)));
 }
 
+// Pins the particle at grid point (x, y), the long range attachments are rebuilt for the new pins on their next pass
+GLvoid Cloth::setFixedParticle(GLuint x, GLuint y) {
+    getParticle(x, y).setFlag(GL_TRUE);
+}
+
 GLvoid Cloth::setStiffness(GLfloat stS, GLfloat shS, GLfloat beS) {
     
-    for (auto c = constraints.begin(); c != constraints.end(); c++) {
-        
-        if (c->type == STRUCTURAL_SPRING)
-            c->Ks = stS;
+    // The Projective Dynamics factor, the Chebyshev radius estimate & the XPBD compliances depend on the spring weights,
+    // all are only redone when they change
+    if ((materials[STRUCTURAL_SPRING].Ks != stS) || (materials[SHEAR_SPRING].Ks != shS) || (materials[BEND_SPRING].Ks != beS)) {
         
-        if (c->type == SHEAR_SPRING)
-            c->Ks = shS;
-        
-        if (c->type == BEND_SPRING) {
-            c->Ks = beS;
-        }
+        projectiveStale = GL_TRUE;
+        jacobiRadius = 0.0f;
+        dConstraints.clear();
     }
-}
-
-GLvoid Cloth::setWire(GLboolean flag) {
-    drawWire = flag;
+    
+    materials[STRUCTURAL_SPRING].Ks = stS;
+    materials[SHEAR_SPRING].Ks = shS;
+    materials[BEND_SPRING].Ks = beS;
 }
 
 GLvoid Cloth::setDamping(GLfloat stD, GLfloat shD, GLfloat beD, GLfloat gD) {
   
+    // The XPBD constraints hold their spring damping as well
+    if ((materials[STRUCTURAL_SPRING].Kd != stD) || (materials[SHEAR_SPRING].Kd != shD) || (materials[BEND_SPRING].Kd != beD))
+        dConstraints.clear();
+    
     GlobalDamping = gD;
     
-    for (auto c = constraints.begin(); c != constraints.end(); c++) {
-        
-        if (c->type == STRUCTURAL_SPRING)
-            c->Kd = stD;
-        
-        if (c->type == SHEAR_SPRING)
-            c->Kd = shD;
-        
-        if (c->type == BEND_SPRING) {
-            c->Kd = beD;
-        }
-    }
+    materials[STRUCTURAL_SPRING].Kd = stD;
+    materials[SHEAR_SPRING].Kd = shD;
+    materials[BEND_SPRING].Kd = beD;
+}
 
-    KdStruct = stD; KdShear = shD; KdBend = beD;
+// Multi-rate evaluations per step of each spring type, the stiff types on the finest substeps
+GLvoid Cloth::setSpringRates(GLuint stR, GLuint shR, GLuint beR) {
+    
+    springRates[STRUCTURAL_SPRING] = glm::max(stR, 1u);
+    springRates[SHEAR_SPRING] = glm::max(shR, 1u);
+    springRates[BEND_SPRING] = glm::max(beR, 1u);
 }
 
 GLvoid Cloth::initExtentions(void) {
     
-    mMat.Clear(GL_FALSE);
-    kMat.Clear(GL_FALSE);
-    X.Clear(GL_FALSE);
-    F.Clear(GL_FALSE);
-    V.Clear(GL_FALSE);
-    Vnew.Clear(GL_FALSE);
-    
     X.Resize(NumP_XY);
     F.Resize(NumP_XY);
     V.Resize(NumP_XY);
     Vnew.Resize(NumP_XY);
     
-    mMat.Resize(NumP_XY);
-    kMat.Resize((GLsizei)constraints.size());
-    
-    GLfloat tMass = 0.0f;
+    X.Clear(GL_FALSE);
+    F.Clear(GL_FALSE);
+    V.Clear(GL_FALSE);
+    Vnew.Clear(GL_FALSE);
     
-    for (auto p = particles.begin(); p != particles.end(); p++)
-        tMass += p->getMass();
+    // Lumped mass, one diagonal block per particle
+    mMat.Resize(NumP_XY);
     
-    mMat = (5.0f) * mMat;
+    for (GLsizei i = 0; i < NumP_XY; i++)
+        mMat[i] = mat3(1.0f / particles.invMass[i]);
 }
 
-GLvoid Cloth::initSpring(Particle* pA, Particle* pB, GLfloat ks, GLfloat kd, GLuint id) {
+GLvoid Cloth::initSpring(GLuint pA, GLuint pB, GLuint id, GLuint colour) {
     
     Spring spring;
     
     spring.particleA = pA;
     spring.particleB = pB;
-    spring.Ks = ks;
-    spring.Kd = kd;
-    spring.type = id;
+    spring.restLength = 0.0f;
+    spring.material = id;
     
     constraints.push_back(spring);
+    springColours.push_back(colour);
 }
 
-GLvoid Cloth::initFace(Particle* pA, Particle* pB, Particle* pC) {
+GLvoid Cloth::initFace(GLuint pA, GLuint pB, GLuint pC) {
     
     Face face;
     
@@ -162,6 +179,15 @@ GLvoid Cloth::initMesh(GLfloat uWidth, GLfloat uHeight, GLuint NumPX, GLuint Num
     
     GLfloat unitDistX = uWidth / NumPX;
     GLfloat unitDistY = uHeight / NumPY;
+    
+    // The mesh is generated in row-major order and reordered once complete
+    gridToParticle.resize(NumP_XY);
+    particleToGrid.resize(NumP_XY);
+    
+    for (GLsizei i = 0; i < NumP_XY; i++) {
+        gridToParticle[i] = i;
+        particleToGrid[i] = i;
+    }
 
     // Create 2D mesh, aligned centre
     for (GLsizei j = 0; j <= NumPY; j++) {
@@ -198,43 +224,215 @@ GLvoid Cloth::initMesh(GLfloat uWidth, GLfloat uHeight, GLuint NumPX, GLuint Num
             /**/
 
             
-            particles[i + (j * (NumPX + 1))] = Particle(particlePos);
-            particles[i + (j * (NumPX + 1))].setIndex(i + (j * (NumPX + 1)));
+            particles.initParticle(i + (j * (NumPX + 1)), particlePos, 5.0f);
             
             generateSprings(i, j);
             
             if (i < NumPX && j < NumPY) {
                 
-                GLuint* element = &vertexIndices[(getParticleIndex(i, j) * I_OFFSET) - (j * I_OFFSET)];
+                GLuint* element = &vertexIndices[(i + (j * NumPX)) * I_OFFSET];
                 
                 generateElementIndices(i, j, element);
                 
-                initFace(getParticle(i + 1, j), getParticle(i, j), getParticle(i, j + 1));
-                initFace(getParticle(i + 1, j + 1), getParticle(i + 1, j), getParticle(i, j + 1));
+                initFace(getParticleIndex(i + 1, j), getParticleIndex(i, j), getParticleIndex(i, j + 1));
+                initFace(getParticleIndex(i + 1, j + 1), getParticleIndex(i + 1, j), getParticleIndex(i, j + 1));
             }
         }
     }
     
     // Set constraints/springs rest length values
     for (auto c = constraints.begin(); c != constraints.end(); c++)
-        c->restLength = distance(c->particleA->getPosition(), c->particleB->getPosition());
+        c->restLength = distance(particles.position[c->particleA], particles.position[c->particleB]);
     
-    // Set faces centre and normal values
-    for (auto f = faces.begin(); f != faces.end(); f++) {
-        f->centrePos = (f->particleA->getPosition() + f->particleB->getPosition() + f->particleC->getPosition()) / 3.0f;
-        f->normal = normalize(getPolyNormal(f->particleA, f->particleB, f->particleC));
-    }
+    // Set faces normal values
+    updateFaceNormals();
+    
+    // Group constraints into batches in which no two constraints share a particle
+    buildConstraintBatches();
+    
+    // Lay particles out along the selected curve, also builds the per particle spring lists
+    setParticleOrdering(ordering);
     
     // Set default fixed particles
    // for (GLsizei i = 0; i <= NumPX; i += (NumPX/1)) {
-        getParticle(0, 0)->setFlag(GL_TRUE);
-        getParticle(NumPX, 0)->setFlag(GL_TRUE);
+        setFixedParticle(0, 0);
+        setFixedParticle(NumPX, 0);
     //}
     
 
 
 }
 
+// Spreads the bits of a 16 bit coordinate over the even bits of the result
+static inline GLuint partBy1(GLuint v) {
+    
+    v &= 0x0000FFFF;
+    v = (v | (v << 8)) & 0x00FF00FF;
+    v = (v | (v << 4)) & 0x0F0F0F0F;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    
+    return(v);
+}
+
+// Nested dissection of the grid block [x0, x1) x [y0, y1) of a W wide grid, each half is ordered before the separator
+// between them. Bend springs span two grid points, so separators are two lines thick
+static GLvoid dissect(GLuint x0, GLuint y0, GLuint x1, GLuint y1, GLuint W, std::vector<GLuint>& order) {
+    
+    const GLuint w = x1 - x0;
+    const GLuint h = y1 - y0;
+    
+    if (((w * h) <= DISSECTION_LEAF) || (glm::max(w, h) < 5)) {
+        
+        for (GLuint y = y0; y < y1; y++) {
+            for (GLuint x = x0; x < x1; x++)
+                order.push_back(x + (y * W));
+        }
+        
+        return;
+    }
+    
+    if (w >= h) {
+        
+        GLuint mid = x0 + ((w - 2) / 2);
+        
+        dissect(x0, y0, mid, y1, W, order);
+        dissect(mid + 2, y0, x1, y1, W, order);
+        dissect(mid, y0, mid + 2, y1, W, order);
+    }
+    else {
+        
+        GLuint mid = y0 + ((h - 2) / 2);
+        
+        dissect(x0, y0, x1, mid, W, order);
+        dissect(x0, mid + 2, x1, y1, W, order);
+        dissect(x0, mid, x1, mid + 2, W, order);
+    }
+}
+
+GLvoid Cloth::setParticleOrdering(ParticleOrdering order) {
+    
+    ordering = order;
+    
+    const GLuint W = NumPX + 1;
+    const GLuint tilesX = (W + TILE_SIZE - 1) / TILE_SIZE;
+    
+    // Sort key of every grid point along the curve, grid points are then numbered in key order
+    std::vector<std::pair<GLuint64, GLuint> > keys(NumP_XY);
+    
+    for (GLsizei g = 0; g < NumP_XY; g++) {
+        
+        GLuint x = g % W;
+        GLuint y = g / W;
+        
+        GLuint64 key = g;
+        
+        switch (ordering) {
+                
+            case TILED:
+                key = ((GLuint64)(((y / TILE_SIZE) * tilesX) + (x / TILE_SIZE)) * (TILE_SIZE * TILE_SIZE)) + ((y % TILE_SIZE) * TILE_SIZE) + (x % TILE_SIZE);
+                break;
+                
+            case MORTON:
+                key = (partBy1(y) << 1) | partBy1(x);
+                break;
+                
+            default:
+                break;
+        }
+        
+        keys[g] = std::make_pair(key, (GLuint)g);
+    }
+    
+    std::sort(keys.begin(), keys.end());
+    
+    std::vector<GLuint> remap(NumP_XY);
+    
+    for (GLsizei k = 0; k < NumP_XY; k++)
+        remap[gridToParticle[keys[k].second]] = k;
+    
+    reorderParticles(remap);
+}
+
+Cloth::ParticleOrdering Cloth::getParticleOrdering(void) const {
+    return(ordering);
+}
+
+// Moves particle i to remap[i], every stored particle index is remapped and constraints are re-sorted within their batches
+GLvoid Cloth::reorderParticles(const std::vector<GLuint>& remap) {
+    
+    particles.permute(remap);
+    
+    for (GLsizei g = 0; g < NumP_XY; g++) {
+        gridToParticle[g] = remap[gridToParticle[g]];
+        particleToGrid[gridToParticle[g]] = g;
+    }
+    
+    for (auto f = faces.begin(); f != faces.end(); f++) {
+        f->particleA = remap[f->particleA];
+        f->particleB = remap[f->particleB];
+        f->particleC = remap[f->particleC];
+    }
+    
+    for (auto e = vertexIndices.begin(); e != vertexIndices.end(); e++)
+        *e = remap[*e];
+    
+    // Springs are oriented from their lower particle and sorted by it, so the force pass streams through the particles in order
+    const GLsizei NumC = (GLsizei)constraints.size();
+    
+    std::vector<std::pair<std::pair<GLuint, GLuint>, GLuint> > keys(NumC);
+    
+    for (GLsizei s = 0; s < NumC; s++) {
+        
+        GLuint a = remap[constraints[s].particleA];
+        GLuint b = remap[constraints[s].particleB];
+        
+        keys[s] = std::make_pair(std::make_pair(glm::min(a, b), glm::max(a, b)), (GLuint)s);
+    }
+    
+    std::sort(keys.begin(), keys.end());
+    
+    std::vector<Spring> sorted(NumC);
+    std::vector<GLuint> springRemap(NumC);
+    
+    for (GLsizei k = 0; k < NumC; k++) {
+        
+        sorted[k] = constraints[keys[k].second];
+        sorted[k].particleA = keys[k].first.first;
+        sorted[k].particleB = keys[k].first.second;
+        
+        springRemap[keys[k].second] = k;
+    }
+    
+    constraints.swap(sorted);
+    
+    // Batches keep their springs, in the same first endpoint order
+    for (auto k = batchSprings.begin(); k != batchSprings.end(); k++)
+        *k = springRemap[*k];
+    
+    for (GLsizei batch = 0; batch < (GLsizei)constraintBatches.size() - 1; batch++)
+        std::sort(batchSprings.begin() + constraintBatches[batch], batchSprings.begin() + constraintBatches[batch + 1]);
+    
+    buildAdjacency();
+    
+    // The system matrix pattern follows the particle numbering, rebuilt by the next implicit step, the warm start is dropped
+    systemMatrix.clear();
+    multigrid.clear();
+    projectiveSystem.clear();
+    dConstraints.clear();
+    springGroups.clear();
+    tetherAnchor.clear();
+    dV.Resize(0);
+}
+
+const ParticleStore& Cloth::getParticles(void) const {
+    return(particles);
+}
+
+const std::vector<Spring>& Cloth::getConstraints(void) const {
+    return(constraints);
+}
+
 GLvoid Cloth::generateElementIndices(GLuint x, GLuint y, GLuint* e){
     
     GLuint e0 = getParticleIndex(x, y);
@@ -248,517 +446,2085 @@ GLvoid Cloth::generateElementIndices(GLuint x, GLuint y, GLuint* e){
 
 GLvoid Cloth::generateSprings(GLuint x, GLuint y) {
     
+    // Structural Spring
+    // Batch colours are analytic on the lattice, springs of one colour and direction never share a particle when their
+    // start columns (or rows) differ in parity, for bend springs spanning two particles the parity of x/2 (or y/2) is used
+    
     // Structural Spring
     if (x < NumPX) {
-        initSpring(getParticle(x, y), getParticle((x + 1), y),
-                   KsStruct, KdStruct, STRUCTURAL_SPRING);
+        initSpring(getParticleIndex(x, y), getParticleIndex((x + 1), y), STRUCTURAL_SPRING, 0 + (x & 1));
     }
     if (y < NumPY) {
-        initSpring(getParticle(x, y), getParticle(x, (y + 1)),
-                   KsStruct, KdStruct, STRUCTURAL_SPRING);
+        initSpring(getParticleIndex(x, y), getParticleIndex(x, (y + 1)), STRUCTURAL_SPRING, 2 + (y & 1));
     }
     
     // Shear Spring
     if (x < NumPX && y < NumPY) {
-        initSpring(getParticle(x, y), getParticle((x + 1), (y + 1)),
-                   KsShear, KdShear, SHEAR_SPRING);
+        initSpring(getParticleIndex(x, y), getParticleIndex((x + 1), (y + 1)), SHEAR_SPRING, 4 + (x & 1));
     }
     if (x < NumPX && y < NumPY) {
-        initSpring(getParticle((x + 1), y), getParticle(x, (y + 1)),
-                   KsShear, KdShear, SHEAR_SPRING);
+        initSpring(getParticleIndex((x + 1), y), getParticleIndex(x, (y + 1)), SHEAR_SPRING, 6 + (x & 1));
     }
     
     // TODO: Fix Bend Springs, need ability to switch between structural bend, stretch bend, and both (PBD) spring setups
 
     
     if (x < NumPX - 1) {
-        initSpring(getParticle(x, y), getParticle((x + 2), y),
-                   KsBend, KdBend, BEND_SPRING);
+        initSpring(getParticleIndex(x, y), getParticleIndex((x + 2), y), BEND_SPRING, 8 + ((x >> 1) & 1));
     }
-    if (y < NumPX - 1) {
-        initSpring(getParticle(x, y), getParticle(x, (y + 2)),
-                   KsBend, KdBend, BEND_SPRING);
+    if (y < NumPY - 1) {
+        initSpring(getParticleIndex(x, y), getParticleIndex(x, (y + 2)), BEND_SPRING, 10 + ((y >> 1) & 1));
     }
     /*if (x < (NumPX - 1) && y < (NumPY - 1)) {
-        initSpring(getParticle(x, y), getParticle((x + 2), (y + 2)),
-                   KsBend, KdBend, BEND_SPRING);
+        initSpring(getParticleIndex(x, y), getParticleIndex((x + 2), (y + 2)), BEND_SPRING, 12 + ((x >> 1) & 1));
     }
     if (x < (NumPX - 1) && y < (NumPY - 1)) {
-        initSpring(getParticle((x + 2), y), getParticle(x, (y + 2)),
-                   KsBend, KdBend, BEND_SPRING);
+        initSpring(getParticleIndex((x + 2), y), getParticleIndex(x, (y + 2)), BEND_SPRING, 14 + ((x >> 1) & 1));
     }*/
     
 }
 
-// Function is to computationally complex, TODO: Optimisation Task, Incoporate per particle 'Compute Forces', per particle 'Integration', and per constraint 'Resolve Forces' iterations into the a single per constraint loop iteration function. 01/03/16
-
+// Explicit & symplectic schemes with a single force evaluation take the fused path, see fusedStep
 GLvoid Cloth::stepSimulation(GLfloat dt, IntegrationMethod m, GLboolean dyIn) {
     
-    computeForces(dt, m);
-    
-    // Position Displacement Integrarion Schemes
-    switch (m) {
+    {
+        PROFILE_SCOPE(profiler, PROFILE_STEP);
+        
+        const GLboolean fused = fuseStep && ((m == F_EULER) || (m == FB_EULER) || (m == VERLET));
+        
+        if (fused)
+            fusedStep(dt, m);
+        else {
             
-        case F_EULER:
-            // TODO, RFT, Forward Euler Method
-            EXP_ForwardEuler(dt);
-            break;
+            // The Runge-Kutta stages evaluate their forces on top of the external forces applied before the step
+            if ((m == RK2_EULER) || (m == RK4_EULER))
+                rkExternal.assign(particles.force.begin(), particles.force.end());
             
-        case B_EULER:
-            // TODO: EFT, Implicit Backward-Euler (BDF) Conjugate Gradient Method, More Info wiki/Euler_methods
-            IMP_BackwardEuler(dt);
-            break;
+            computeForces(dt, m);
             
-        case MB_EULER:
-            // TODO: EFT, Implicit Backward-Euler (BDF) Pre-Conditioned Conjugate Gradient Method, from Baraff & Witkin [1998]
-            IMP_ModifiedBackwardEuler(dt);
-            dForceDV.clear();
-            dForceDX.clear();
-            break;
+            // Position Displacement Integrarion Schemes
+            switch (m) {
+                    
+                case F_EULER:
+                    // TODO, RFT, Forward Euler Method
+                    EXP_ForwardEuler(dt);
+                    break;
+                    
+                case B_EULER:
+                    // TODO: EFT, Implicit Backward-Euler (BDF) Conjugate Gradient Method, More Info wiki/Euler_methods
+                    IMP_BackwardEuler(dt);
+                    break;
+                    
+                case MB_EULER:
+                    // TODO: EFT, Implicit Backward-Euler (BDF) Pre-Conditioned Conjugate Gradient Method, from Baraff & Witkin [1998]
+                    IMP_ModifiedBackwardEuler(dt);
+                    break;
+                    
+                case FB_EULER:
+                    // TODO: EFT, Symplectic Euler Method, wiki/Symplectic_Euler_method
+                    SYM_ForwardBackwardEuler(dt);
+                    break;
+                    
+                case MFB_EULER:
+                    // TODO: EFT, IMplicit-EXplicit Modified Euler (Newton-Krylov Solver) Method from Desbrun et al. [1999/ref2]
+                    SYM_ModifiedForwardBackwardEuler(dt);
+                    break;
+                    
+                case RK2_EULER:
+                    // TODO: EFT, Explicit Midpoint-Euler/RK2 Method, More Info @ wiki/Runge-Kutta_methods
+                    EXP_RungeKutta2(dt);
+                    break;
+                    
+                case RK4_EULER:
+                    // TODO: RFT, Explicit Runge-Kutta 4th Order Method, More Info @ wiki/Runge-Kutta_methods
+                    EXP_RungeKutta4(dt);
+                    break;
+                    
+                case VERLET:
+                    // TODO: RFT, Verlet Method
+                    EXP_Verlet(dt);
+                    break;
+                    
+                case PROJECTIVE:
+                    // Projective Dynamics, local spring projections & a prefactored global solve, Bouaziz et al. [2014]
+                    IMP_ProjectiveDynamics(dt);
+                    break;
+                    
+                case XPBD:
+                    // Extended Position Based Dynamics, compliant constraints over substeps, Macklin et al. [2016]
+                    PBD_ExtendedPositionBased(dt);
+                    break;
+                    
+                case MULTIRATE:
+                    // Multi-rate Symplectic Euler, stiff springs on fine substeps, soft springs & external forces held
+                    SYM_MultiRateEuler(dt);
+                    break;
+                    
+                case DEFAULT:
+                    break;
+            }
+        }
+        
+        // XPBD already projects the springs as constraints & keeps its velocities consistent with the positions, a further
+        // pass over the same springs only moves the positions away from the converged, damped solve
+        if (dyIn && (m != XPBD))
+            constraintsInverse(m);
+        
+        // reset forces for all particles, the fused step resets them as it goes
+        if (!fused) {
             
-        case FB_EULER:
-            // TODO: EFT, Symplectic Euler Method, wiki/Symplectic_Euler_method
-            SYM_ForwardBackwardEuler(dt);
-            break;
+            vec3* force = &particles.force[0];
+            
+            #pragma omp parallel for schedule(static) if (parallelForces())
+            for (GLsizei i = 0; i < NumP_XY; i++)
+                force[i] = vec3(0);
+        }
+        
+        // Contacts found by the collision passes hold for this step only
+        if (collisionFlag) {
+            
+            std::fill(particles.collision.begin(), particles.collision.end(), GL_FALSE);
+            collisionFlag = GL_FALSE;
+        }
+    }
+    
+#ifdef CLOTH_PROFILING
+    profiler.endFrame();
+#endif
+}
+
+// One frame of frameTime, as a single step or, with an adaptive policy, as steps sized for the scheme. Explicit schemes are
+// controlled by a step doubling error estimate, symplectic schemes take a fraction of their stability bound and the
+// unconditionally stable schemes split the frame only past maxStep. Time the frame budget cannot cover is dropped rather
+// than taken in steps past the bound. The external forces & contacts of the frame hold for each of its steps. Returns the
+// number of steps taken
+GLsizei Cloth::advanceFrame(GLfloat frameTime, IntegrationMethod m, GLboolean dyIn) {
+    
+    StepStats stats = { 0, 0, frameTime, frameTime, 0.0f, GL_FALSE, 0, 0, 0, 0.0f, 0 };
+    stepStats = stats;
+    
+    if (!stepPolicy.adaptive) {
+        
+        stepSimulation(frameTime, m, dyIn);
+        stepStats.steps = 1;
+        
+        return(stepStats.steps);
+    }
+    
+    stepExternal.assign(particles.force.begin(), particles.force.end());
+    
+    // Contacts are cleared once the frame is done rather than after its first step
+    const GLboolean contacts = collisionFlag;
+    collisionFlag = GL_FALSE;
+    
+    const GLsizei budget = glm::max(stepPolicy.maxSteps, 1);
+    
+    GLsizei order = 0;
+    
+    switch (m) {
             
-        case MFB_EULER:
-            // TODO: EFT, IMplicit-EXplicit Modified Euler (Newton-Krylov Solver) Method from Desbrun et al. [1999/ref2]
-            SYM_ModifiedForwardBackwardEuler(dt);
-            pForce.clear();
+        case F_EULER:
+            order = 1;
             break;
             
         case RK2_EULER:
-            // TODO: EFT, Explicit Midpoint-Euler/RK2 Method, More Info @ wiki/Runge-Kutta_methods
-            EXP_RungeKutta2(dt);
+            order = 2;
             break;
             
         case RK4_EULER:
-            // TODO: RFT, Explicit Runge-Kutta 4th Order Method, More Info @ wiki/Runge-Kutta_methods
-            EXP_RungeKutta4(dt);
-            sForce.clear();
-            sVelocity.clear();
-            break;
-            
-        case VERLET:
-            // TODO: RFT, Verlet Method
-            EXP_Verlet(dt);
+            order = 4;
             break;
             
-        case DEFAULT:
+        default:
             break;
     }
     
-    if (dyIn) 
-        constraintsInverse(m);
-    
-    // reset forces for all particles
-    for (auto p = particles.begin(); p != particles.end(); p++)
-        p->resetForce();
-     
-}
-
-GLvoid Cloth::computeForces(GLfloat dt = NULL, IntegrationMethod m = DEFAULT) {
-    
-    mat3 I = mat3(1);
-    
-    // Compute Forces Per Particle
-    for (auto p = particles.begin(); p != particles.end(); p++) {
+    if (order == 0) {
         
-        if (m == VERLET)
-            p->setVelocity(verletVelocity(*p, dt));
+        GLfloat bound = stepPolicy.maxStep;
         
-        // + G-force
-        if (p->getFlag()) {
+        if ((m == FB_EULER) || (m == MFB_EULER) || (m == VERLET) || (m == MULTIRATE))
+            bound = glm::min(bound, stepPolicy.safety * stabilityStep(m));
+        
+        // Equal steps under the bound, limited only when the budget cuts the step count, the steps are then held at the
+        // bound & the frame is left short
+        const GLfloat needed = glm::max(std::ceil(frameTime / bound), 1.0f);
+        
+        stepStats.limited = (needed > budget);
+        
+        GLsizei steps = stepStats.limited ? budget : (GLsizei)needed;
+        GLfloat dt = stepStats.limited ? bound : (frameTime / steps);
+        
+        stepStats.time = stepStats.limited ? (steps * dt) : frameTime;
+        
+        for (GLsizei k = 0; k < steps; k++) {
             
-            if (m == VERLET)
-                p->addForce(Gravity * p->getMass());
-            else
-                p->addForce(Gravity);
+            if (k > 0)
+                std::copy(stepExternal.begin(), stepExternal.end(), particles.force.begin());
+            
+            stepSimulation(dt, m, dyIn);
         }
         
-        // + Force Due To Dampening
-        if (m == VERLET)
-            p->addForce(GlobalDamping * verletVelocity(*p, dt)); // Position Based
-        else
-            p->addForce(GlobalDamping * p->getVelocity()); // Force Based
+        stepStats.steps = steps;
+        stepStats.step = dt;
     }
-
-    GLsizei ittInd = 0;
-    
-    // Resolve Forces Per Constraint
-    for (auto c = constraints.begin(); c != constraints.end(); c++) {
+    else {
         
-        vec3 deltaP = c->particleA->getPosition() - c->particleB->getPosition();
-        vec3 deltaV = c->particleA->getVelocity() - c->particleB->getVelocity();
+        const GLfloat exponent = 1.0f / (order + 1);
         
-        GLfloat sLength = glm::length(deltaP);
+        GLfloat remaining = frameTime;
         
-        // TODO: Calculate Derivative Force, Baraff & Witkin [1998/ref3], Section 4.1 pp. 46
-        if (m == MB_EULER) {
-            
-            vec3 deltaP2 = deltaP * deltaP;
-            vec3 pdC_pdX = deltaP / sLength;
+        if (stepProposal <= 0.0f)
+            stepProposal = glm::min(frameTime, stepPolicy.maxStep);
+        
+        // Rejected trial steps count against the budget, each costs three steps
+        while ((remaining > 0.0f) && ((stepStats.steps + stepStats.rejected) < budget)) {
             
-            GLfloat C = sLength - c->restLength;
-            GLfloat C_DOT = dot(c->particleA->getVelocity(), -pdC_pdX) + dot(c->particleB->getVelocity(), pdC_pdX);
+            GLfloat dt = glm::min(glm::min(stepProposal, stepPolicy.maxStep), remaining);
             
-            mat3 pdF_pdX, pdF_pdV;
-            mat3 pd2C_pdX2[2][2];
+            // A step that would leave a sliver below minStep takes what remains
+            if ((remaining - dt) < stepPolicy.minStep)
+                dt = remaining;
             
-            pd2C_pdX2[0][0][0][0] = (-C * deltaP2.x) + C;
-            pd2C_pdX2[0][0][1][1] = (-C * deltaP2.y) + C;
-            pd2C_pdX2[0][0][2][2] = (-C * deltaP2.z) + C;
+            const GLboolean truncated = (dt < stepProposal);
             
-            pd2C_pdX2[0][1][0][0] = (C * deltaP2.x) - C;
-            pd2C_pdX2[0][1][1][1] = (C * deltaP2.y) - C;
-            pd2C_pdX2[0][1][2][2] = (C * deltaP2.z) - C;
+            GLfloat ratio = doubledStep(dt, m, dyIn) / stepPolicy.tolerance;
             
-            pd2C_pdX2[1][0] = pd2C_pdX2[0][1];
-            pd2C_pdX2[1][1] = pd2C_pdX2[0][0];
+            GLfloat factor = (ratio > 0.0f) ? (0.9f * std::pow(1.0f / ratio, exponent)) : STEP_GROWTH;
+            factor = glm::clamp(factor, STEP_SHRINK, STEP_GROWTH);
             
-            mat3 pdX1 = outerProduct(pdC_pdX, pdC_pdX);
-            mat3 pdX2 = outerProduct(pdC_pdX, -pdC_pdX);
-            mat3 pdX3 = outerProduct(-pdC_pdX, -pdC_pdX);
+            if ((ratio > 1.0f) && (dt > stepPolicy.minStep)) {
+                
+                restoreStepState();
+                
+                stepStats.rejected++;
+                stepProposal = glm::max(dt * factor, stepPolicy.minStep);
+                continue;
+            }
             
-            pdF_pdX += - (c->Ks * (pdX1 + (pd2C_pdX2[0][0] * C))) - (c->Kd * (pd2C_pdX2[0][0] * C_DOT));
-            pdF_pdX += - (c->Ks * (pdX2 + (pd2C_pdX2[0][1] * C))) - (c->Kd * (pd2C_pdX2[0][1] * C_DOT));
-            pdF_pdX += - (c->Ks * (pdX3 + (pd2C_pdX2[1][1] * C))) - (c->Kd * (pd2C_pdX2[1][1] * C_DOT)); // Problem potentially here
+            stepStats.limited |= (ratio > 1.0f);
+            stepStats.steps++;
+            stepStats.step = dt;
+            stepStats.error = ratio;
             
-            pdF_pdV += - c->Kd * pdX1;
-            pdF_pdV += - c->Kd * pdX2;
-            pdF_pdV += - c->Kd * pdX3;
+            remaining -= dt;
             
-            dForceDX.push_back(pdF_pdX);
-            dForceDV.push_back(pdF_pdV);
+            // A step cut short by the end of the frame says nothing against the proposal
+            stepProposal = truncated ? glm::max(stepProposal, dt * factor) : (dt * factor);
+            stepProposal = glm::clamp(stepProposal, stepPolicy.minStep, stepPolicy.maxStep);
         }
         
-        if (B_EULER) {
-            
-            // Constraints Stiffness Jacobian
-            kMat[ittInd] = c->Ks * ( ( (c->restLength / sLength) * (I - outerProduct(deltaP, deltaP)/pow(sLength, sLength))) - I);
-            ittInd++;
-        }
+        stepStats.limited |= (remaining > 0.0f);
+        stepStats.time = frameTime - remaining;
+    }
+    
+    if (contacts)
+        std::fill(particles.collision.begin(), particles.collision.end(), GL_FALSE);
+    
+    return(stepStats.steps);
+}
+
+// One step of dt and two of dt / 2 from the same state, the two half steps are kept. The difference of the two solutions
+// scaled by 1 / (2^p - 1), Richardson's estimate of the error left in the half step solution, is returned as the largest
+// position error, non-finite solutions return FLT_MAX
+GLfloat Cloth::doubledStep(GLfloat dt, IntegrationMethod m, GLboolean dyIn) {
+    
+    stepPosition.assign(particles.position.begin(), particles.position.end());
+    stepVelocity.assign(particles.velocity.begin(), particles.velocity.end());
+    stepLastPosition.assign(particles.lastPosition.begin(), particles.lastPosition.end());
+    stepLastVelocity.assign(particles.lastVelocity.begin(), particles.lastVelocity.end());
+    
+    std::copy(stepExternal.begin(), stepExternal.end(), particles.force.begin());
+    stepSimulation(dt, m, dyIn);
+    
+    stepTrial.assign(particles.position.begin(), particles.position.end());
+    
+    restoreStepState();
+    stepSimulation(dt / 2.0f, m, dyIn);
+    
+    std::copy(stepExternal.begin(), stepExternal.end(), particles.force.begin());
+    stepSimulation(dt / 2.0f, m, dyIn);
+    
+    const GLfloat scale = (m == F_EULER) ? 1.0f : ((m == RK2_EULER) ? (1.0f / 3.0f) : (1.0f / 15.0f));
+    
+    const vec3* position = &particles.position[0];
+    const vec3* trial = &stepTrial[0];
+    
+    GLfloat error = 0.0f;
+    
+    #pragma omp parallel for schedule(static) reduction(max : error) if (parallelForces())
+    for (GLsizei i = 0; i < NumP_XY; i++) {
         
-        GLfloat LHS = -(c->Ks) * (sLength - c->restLength);
-        GLfloat RHS = c->Kd * (dot(deltaV, deltaP) / sLength);
+        GLfloat e = distance(position[i], trial[i]);
         
-        vec3 ResultantForce = (LHS + RHS) * glm::normalize(deltaP);
+        // NaN compares false, so it is caught here rather than lost in the max
+        if (!(e <= FLT_MAX))
+            e = FLT_MAX;
         
-            c->particleA->addForce(ResultantForce);
-            c->particleB->addForce(-ResultantForce);
+        error = glm::max(error, e);
     }
     
+    return((error < FLT_MAX) ? (error * scale) : FLT_MAX);
 }
 
-// Extended Feature, 'Dynamic Inverse' on constraints, Provot [1995/ref1], 'Deformation constraints in a mass-spring model to describe rigid cloth behavior' Section 5
+// State before the last doubled step, with the frame's external forces
+GLvoid Cloth::restoreStepState(void) {
+    
+    std::copy(stepPosition.begin(), stepPosition.end(), particles.position.begin());
+    std::copy(stepVelocity.begin(), stepVelocity.end(), particles.velocity.begin());
+    std::copy(stepLastPosition.begin(), stepLastPosition.end(), particles.lastPosition.begin());
+    std::copy(stepLastVelocity.begin(), stepLastVelocity.end(), particles.lastVelocity.begin());
+    std::copy(stepExternal.begin(), stepExternal.end(), particles.force.begin());
+}
 
-GLvoid Cloth::constraintsInverse(IntegrationMethod m = DEFAULT) {
+// CFL-style bound of the symplectic schemes, dt < 2 / (w + b). The largest frequency w of the springs is bounded by
+// Gershgorin's theorem on M^-1 K, each spring adds 2 Ks to its particles' rows, the stiffness along a spring & the tension
+// across it are both at most Ks. The damping rate b is bounded in the same way from Kd & the global damping. A spring type
+// on r substeps of the multi-rate scheme only needs dt / r under its own bound, so contributes Ks / r^2 & Kd / r
+GLfloat Cloth::stabilityStep(IntegrationMethod m) {
     
-    for (auto c = constraints.begin(); c != constraints.end(); c++) {
-        
-        // Implementation not currently working correctly - could be an inherited issue, 11/02/2016
+    const GLfloat* invMass = &particles.invMass[0];
+    const GLboolean* movable = &particles.movable[0];
+    
+    GLfloat rate = 0.0f;
+    
+    #pragma omp parallel for schedule(static) reduction(max : rate) if (parallelForces())
+    for (GLsizei i = 0; i < NumP_XY; i++) {
         
-        vec3 deltaP = c->particleA->getPosition() - c->particleB->getPosition();
+        if (!movable[i])
+            continue;
         
-        GLfloat cLength = length(deltaP); // length of constraint
+        GLfloat Ks = 0.0f;
+        GLfloat Kd = std::fabs(GlobalDamping);
         
-        if (cLength > c->restLength) {
+        for (GLuint k = adjacencyOffsets[i]; k < adjacencyOffsets[i + 1]; k++) {
             
-            cLength -= c->restLength; // length difference between constraint and its rest length
-            cLength /= 2.0f;
-            deltaP = glm::normalize(deltaP); // unit normal
-            deltaP *= cLength;
+            const GLuint type = constraints[adjacency[k] >> 1].material;
+            const GLfloat r = (m == MULTIRATE) ? (GLfloat)springRates[type] : 1.0f;
             
-            if (!(c->particleA->getFlag())) {
-                
-                if (m == VERLET)
-                    c->particleB->offsetPosition(deltaP);
-                else
-                    c->particleB->offsetVelocity(deltaP);
-            } else if (!(c->particleB->getFlag())) {
-                
-                if (m == VERLET)
-                    c->particleA->offsetPosition(-deltaP);
-                else
-                    c->particleA->offsetVelocity(-deltaP);
-            } else {
-                
-                if (m == VERLET) {
-                    
-                    c->particleA->offsetPosition(-deltaP);
-                    c->particleB->offsetPosition(deltaP);
-                } else {
-                    
-                    c->particleA->offsetVelocity(-deltaP);
-                    c->particleB->offsetVelocity(deltaP);
-                }
-            }
+            Ks += 2.0f * std::fabs(materials[type].Ks) / (r * r);
+            Kd += 2.0f * std::fabs(materials[type].Kd) / r;
         }
+        
+        rate = glm::max(rate, (std::sqrt(Ks * invMass[i]) + (Kd * invMass[i])));
     }
+    
+    return((rate > 0.0f) ? (2.0f / rate) : stepPolicy.maxStep);
 }
 
-/// INTEGRATION SCHEMES
-
-// Jacobsen [2001/ref4], The precursor to position based dynamics formalised in Müller et al. [2006]
-GLvoid Cloth::EXP_Verlet(GLfloat dt) {
+GLvoid Cloth::setStepPolicy(const StepPolicy& policy) {
     
-    for (auto p = particles.begin(); p != particles.end(); p++) {
+    stepPolicy = policy;
+    stepProposal = 0.0f;
+    
+    StepStats stats = { 0, 0, 0.0f, 0.0f, 0.0f, GL_FALSE, 0, 0, 0, 0.0f, 0 };
+    stepStats = stats;
+}
+
+const Cloth::StepPolicy& Cloth::getStepPolicy(void) const {
+    return(stepPolicy);
+}
+
+const Cloth::StepStats& Cloth::getStepStats(void) const {
+    return(stepStats);
+}
+
+// Per particle force computation, per constraint force resolution, per particle integration and the force reset in
+// as few passes as possible. Springs are sorted by their first (lower) particle, so once the springs of every particle
+// below p have been resolved, particle p holds its complete force and is not read again by any later spring
+GLvoid Cloth::fusedStep(GLfloat dt, IntegrationMethod m) {
+    
+    PROFILE_SCOPE(profiler, PROFILE_FUSED);
+    
+    vec3* force = &particles.force[0];
+    vec3* velocity = &particles.velocity[0];
+    const GLfloat* invMass = &particles.invMass[0];
+    const GLboolean* movable = &particles.movable[0];
+    
+    const GLsizei NumC = (GLsizei)constraints.size();
+    
+    if (parallelForces()) {
+        
+        // Threads may not integrate a particle another thread's spring still has to read, so spring forces are
+        // evaluated first and each particle then gathers, integrates and resets in one pass
+        if (m == VERLET) {
+            
+            #pragma omp parallel for schedule(static)
+            for (GLsizei i = 0; i < NumP_XY; i++)
+                velocity[i] = verletVelocity(i, dt);
+        }
+        
+        evaluateSprings(m);
+        
+        #pragma omp parallel for schedule(static)
+        for (GLsizei i = 0; i < NumP_XY; i++) {
+            
+            vec3 F = force[i];
+            
+            if (movable[i])
+                F += (m == VERLET) ? (Gravity / invMass[i]) : Gravity;
+            
+            F += GlobalDamping * velocity[i];
+            
+            for (GLuint k = adjacencyOffsets[i]; k < adjacencyOffsets[i + 1]; k++) {
+                
+                GLuint ref = adjacency[k];
+                
+                if (ref & 1)
+                    F -= springForce[ref >> 1];
+                else
+                    F += springForce[ref >> 1];
+            }
+            
+            force[i] = F;
+            integrateParticle(i, dt, m);
+            force[i] = vec3(0);
+        }
+        
+        return;
+    }
+    
+    GLsizei s0 = 0;
+    GLsizei vFront = 0; // Verlet velocities are derived up to, not including, this particle
+    
+    for (GLsizei p0 = 0; p0 < NumP_XY; p0 += FUSED_TILE) {
+        
+        GLsizei p1 = glm::min(p0 + FUSED_TILE, NumP_XY);
+        GLsizei s1 = s0;
+        GLsizei reach = p1;
+        
+        // Springs whose first particle lies in the tile, and the furthest particle they read
+        while ((s1 < NumC) && (constraints[s1].particleA < (GLuint)p1)) {
+            reach = glm::max(reach, (GLsizei)constraints[s1].particleB + 1);
+            s1++;
+        }
+        
+        if (m == VERLET) {
+            
+            for (; vFront < reach; vFront++)
+                velocity[vFront] = verletVelocity(vFront, dt);
+        }
+        
+        for (GLsizei i = p0; i < p1; i++) {
+            
+            if (movable[i])
+                force[i] += (m == VERLET) ? (Gravity / invMass[i]) : Gravity;
+            
+            force[i] += GlobalDamping * velocity[i];
+        }
+        
+        springKernel.evaluate(&constraints[0], &materials[0], &particles.position[0], velocity, &springForce[0], s0, s1);
+        
+        for (GLsizei s = s0; s < s1; s++) {
+            
+            force[constraints[s].particleA] += springForce[s];
+            force[constraints[s].particleB] -= springForce[s];
+        }
+        
+        // Every spring of the tile's particles has now been resolved
+        for (GLsizei i = p0; i < p1; i++) {
+            
+            integrateParticle(i, dt, m);
+            force[i] = vec3(0);
+        }
+        
+        s0 = s1;
+    }
+}
+
+GLvoid Cloth::computeForces(GLfloat dt = NULL, IntegrationMethod m = DEFAULT) {
+    
+    PROFILE_SCOPE(profiler, PROFILE_FORCES);
+    
+    vec3* force = &particles.force[0];
+    vec3* velocity = &particles.velocity[0];
+    const GLfloat* invMass = &particles.invMass[0];
+    const GLboolean* movable = &particles.movable[0];
+    
+    const GLsizei NumC = (GLsizei)constraints.size();
+    
+    // Compute Forces Per Particle
+    #pragma omp parallel for schedule(static) if (parallelForces())
+    for (GLsizei i = 0; i < NumP_XY; i++) {
+        
+        if (m == VERLET)
+            velocity[i] = verletVelocity(i, dt);
+        
+        // + G-force
+        if (movable[i]) {
+            
+            if (m == VERLET)
+                force[i] += Gravity / invMass[i];
+            else
+                force[i] += Gravity;
+        }
+        
+        // + Force Due To Dampening, XPBD damps implicitly in each substep
+        if (m != XPBD)
+            force[i] += GlobalDamping * velocity[i]; // Verlet velocity is position based, set above
+    }
+    
+    // Projective Dynamics & XPBD resolve the springs as constraints and the multi-rate scheme evaluates them on its own
+    // substeps, only the external forces are accumulated
+    if ((m == PROJECTIVE) || (m == XPBD) || (m == MULTIRATE))
+        return;
+    
+    // Resolve Forces Per Constraint
+    evaluateSprings(m);
+    
+    switch (accumulation) {
+            
+        case SERIAL_SCATTER:
+            
+            for (GLsizei s = 0; s < NumC; s++) {
+                
+                force[constraints[s].particleA] += springForce[s];
+                force[constraints[s].particleB] -= springForce[s];
+            }
+            break;
+            
+        case THREAD_BUFFERS:
+            
+            // Each thread scatters its share of springs into a private force buffer, the buffers are then reduced per particle
+            #pragma omp parallel if (parallelForces())
+            {
+                GLsizei tid = 0;
+                GLsizei nThreads = 1;
+#ifdef _OPENMP
+                tid = omp_get_thread_num();
+                nThreads = omp_get_num_threads();
+#endif
+                #pragma omp single
+                if (threadForces.size() < (size_t)(nThreads * NumP_XY))
+                    threadForces.resize(nThreads * NumP_XY);
+                
+                vec3* tForce = &threadForces[tid * NumP_XY];
+                
+                for (GLsizei i = 0; i < NumP_XY; i++)
+                    tForce[i] = vec3(0);
+                
+                #pragma omp for schedule(static)
+                for (GLsizei s = 0; s < NumC; s++) {
+                    
+                    tForce[constraints[s].particleA] += springForce[s];
+                    tForce[constraints[s].particleB] -= springForce[s];
+                }
+                
+                #pragma omp for schedule(static)
+                for (GLsizei i = 0; i < NumP_XY; i++) {
+                    
+                    for (GLsizei t = 0; t < nThreads; t++)
+                        force[i] += threadForces[(t * NumP_XY) + i];
+                }
+            }
+            break;
+            
+        case GATHER:
+            
+            // Each particle sums the springs it owns in a fixed order
+            #pragma omp parallel if (parallelForces())
+            {
+                #pragma omp for schedule(static)
+                for (GLsizei i = 0; i < NumP_XY; i++) {
+                    
+                    vec3 sum = vec3(0);
+                    
+                    for (GLuint k = adjacencyOffsets[i]; k < adjacencyOffsets[i + 1]; k++) {
+                        
+                        GLuint ref = adjacency[k];
+                        
+                        if (ref & 1)
+                            sum -= springForce[ref >> 1];
+                        else
+                            sum += springForce[ref >> 1];
+                    }
+                    
+                    force[i] += sum;
+                }
+            }
+            break;
+    }
+}
+
+// Resultant force of every spring on its first particle into springForce, the second particle receives its negation
+GLvoid Cloth::evaluateSprings(IntegrationMethod m) {
+    
+    const GLsizei NumC = (GLsizei)constraints.size();
+    
+    if ((m == B_EULER) || (m == MB_EULER)) {
+        
+        // The implicit schemes also fill the force Jacobians in place, one spring at a time
+        if (kMat.size() != NumC)
+            kMat.Resize(NumC);
+        
+        if ((m == MB_EULER) && (dMat.size() != NumC))
+            dMat.Resize(NumC);
+        
+        #pragma omp parallel for schedule(static) if (parallelForces())
+        for (GLsizei s = 0; s < NumC; s++)
+            springForce[s] = evaluateSpring(s, m);
+        
+        return;
+    }
+    
+    const GLsizei NumBlocks = (NumC + SPRING_BLOCK - 1) / SPRING_BLOCK;
+    
+    #pragma omp parallel for schedule(static) if (parallelForces())
+    for (GLsizei block = 0; block < NumBlocks; block++) {
+        
+        GLsizei first = block * SPRING_BLOCK;
+        GLsizei last = glm::min(first + SPRING_BLOCK, NumC);
+        
+        springKernel.evaluate(&constraints[0], &materials[0], &particles.position[0], &particles.velocity[0],
+                              &springForce[0], first, last);
+    }
+}
+
+// Resultant force of a single spring acting on its first particle, the second particle receives its negation
+inline vec3 Cloth::evaluateSpring(GLsizei s, IntegrationMethod m) {
+    
+    const Spring& c = constraints[s];
+    const SpringMaterial& mat = materials[c.material];
+    
+    vec3 deltaP = particles.position[c.particleA] - particles.position[c.particleB];
+    vec3 deltaV = particles.velocity[c.particleA] - particles.velocity[c.particleB];
+    
+    GLfloat sLength = glm::length(deltaP);
+    
+    if ((m == B_EULER) || (m == MB_EULER)) {
+        
+        mat3 I = mat3(1);
+        vec3 n = deltaP / sLength;
+        mat3 nnT = outerProduct(n, n);
+        
+        // Constraints Stiffness Jacobian, ∂F/∂X = -Ks (nnT + (1 - r / |x|) (I - nnT)), Baraff & Witkin [1998]
+        // The transverse term is dropped under compression, keeping each block negative semi-definite and M - dt^2 K positive definite
+        GLfloat transverse = glm::max(1.0f - (c.restLength / sLength), 0.0f);
+        
+        kMat[s] = -mat.Ks * (nnT + (transverse * (I - nnT)));
+        
+        // Damping Jacobian, ∂F/∂V = Kd nnT, damping acts along the spring only
+        if (m == MB_EULER)
+            dMat[s] = mat.Kd * nnT;
+    }
+    
+    GLfloat LHS = -(mat.Ks) * (sLength - c.restLength);
+    GLfloat RHS = mat.Kd * (dot(deltaV, deltaP) / sLength);
+    
+    return((LHS + RHS) * glm::normalize(deltaP));
+}
+
+GLvoid Cloth::setForceAccumulation(ForceAccumulation mode) {
+    
+    accumulation = mode;
+    
+    if (accumulation != THREAD_BUFFERS)
+        threadForces.clear();
+}
+
+GLvoid Cloth::setFusedStep(GLboolean fuse) {
+    fuseStep = fuse;
+}
+
+GLvoid Cloth::setSpringKernel(SpringKernel::ISA isa) {
+    springKernel.setISA(isa);
+}
+
+inline GLboolean Cloth::parallelForces(void) {
+    return((accumulation != SERIAL_SCATTER) && (NumP_XY >= PARALLEL_THRESHOLD));
+}
+
+// Per particle spring lists, entries are (spring << 1) | side where side 1 marks the spring's second particle
+GLvoid Cloth::buildAdjacency(void) {
+    
+    adjacencyOffsets.assign(NumP_XY + 1, 0);
+    
+    for (auto c = constraints.begin(); c != constraints.end(); c++) {
+        adjacencyOffsets[c->particleA + 1]++;
+        adjacencyOffsets[c->particleB + 1]++;
+    }
+    
+    for (GLsizei i = 0; i < NumP_XY; i++)
+        adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+    
+    adjacency.resize(adjacencyOffsets[NumP_XY]);
+    
+    std::vector<GLuint> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    
+    for (GLsizei s = 0; s < (GLsizei)constraints.size(); s++) {
+        adjacency[fill[constraints[s].particleA]++] = (s << 1);
+        adjacency[fill[constraints[s].particleB]++] = (s << 1) | 1;
+    }
+    
+    springForce.resize(constraints.size());
+}
+
+// Weights of the Chebyshev semi-iterative method for an iteration of spectral radius rho, Golub & Van Loan [1996]
+// w_1 = 1, w_2 = 2 / (2 - rho^2), w_k+1 = 4 / (4 - rho^2 w_k), for iteration k counted from 0
+static inline GLfloat chebyshevOmega(GLsizei k, GLfloat rho, GLfloat omega) {
+    
+    if (k == 0)
+        return(1.0f);
+    
+    if (k == 1)
+        return(2.0f / (2.0f - (rho * rho)));
+    
+    return(4.0f / (4.0f - ((rho * rho) * omega)));
+}
+
+// Extended Feature, 'Dynamic Inverse' on constraints, Provot [1995/ref1], 'Deformation constraints in a mass-spring model to describe rigid cloth behavior' Section 5
+
+GLvoid Cloth::constraintsInverse(IntegrationMethod m = DEFAULT) {
+    
+    PROFILE_SCOPE(profiler, PROFILE_INVERSE);
+    
+    if (constraintSolver == ACCELERATED_JACOBI) {
+        
+        constraintsJacobi(m);
+        return;
+    }
+    
+    // Tethers bound the global stretch first, the coloured pass below then bounds the local stretch
+    if (constraintSolver == LONG_RANGE_ATTACHMENTS)
+        constraintsTethers(m);
+    
+    vec3* position = &particles.position[0];
+    vec3* velocity = &particles.velocity[0];
+    const GLboolean* movable = &particles.movable[0];
+    
+    // Verlet is corrected in place, force based schemes through their velocities, XPBD is never passed here
+    vec3* target = (m == VERLET) ? position : velocity;
+    
+    // No two constraints of a batch share a particle, so each batch is corrected in parallel without atomics
+    for (GLsizei batch = 0; batch < (GLsizei)constraintBatches.size() - 1; batch++) {
+        
+        const GLsizei first = constraintBatches[batch];
+        const GLsizei last = constraintBatches[batch + 1];
+        
+        #pragma omp parallel for schedule(static) if (parallelBatch(batch))
+        for (GLsizei k = first; k < last; k++) {
+            
+            // Implementation not currently working correctly - could be an inherited issue, 11/02/2016
+            
+            const Spring& c = constraints[batchSprings[k]];
+            
+            GLuint a = c.particleA;
+            GLuint b = c.particleB;
+            
+            vec3 deltaP = position[a] - position[b];
+            
+            GLfloat cLength = length(deltaP); // length of constraint
+            
+            if (cLength > c.restLength) {
+                
+                cLength -= c.restLength; // length difference between constraint and its rest length
+                cLength /= 2.0f;
+                deltaP = glm::normalize(deltaP); // unit normal
+                deltaP *= cLength;
+                
+                if (!(movable[a])) {
+                    
+                    target[b] += deltaP;
+                } else if (!(movable[b])) {
+                    
+                    target[a] -= deltaP;
+                } else {
+                    
+                    target[a] -= deltaP;
+                    target[b] += deltaP;
+                }
+            }
+        }
+    }
+}
+
+// Jacobi form of the Provot pass, Wang [2015], 'A Chebyshev Semi-Iterative Approach for Accelerating Projective and
+// Position-based Dynamics'. Every spring is corrected from the same iterate and each particle averages the corrections
+// of its stretched springs, so no batches are needed. The iterates are extrapolated with the Chebyshev weights of a
+// spectral radius measured by the first call, the displacement of the last iterate is then applied to the target
+GLvoid Cloth::constraintsJacobi(IntegrationMethod m) {
+    
+    const vec3* position = &particles.position[0];
+    vec3* velocity = &particles.velocity[0];
+    const GLboolean* movable = &particles.movable[0];
+    
+    const GLsizei NumC = (GLsizei)constraints.size();
+    
+    jacobiPositions.assign(particles.position.begin(), particles.position.end());
+    jacobiPrevious.assign(particles.position.begin(), particles.position.end());
+    springCorrection.resize(NumC);
+    
+    vec3* c = &springCorrection[0];
+    
+    // The warm-up iterations are plain relaxed Jacobi, their update norms are summed serially so the estimate is reproducible
+    const GLboolean warmUp = (constraintRadius <= 0.0f);
+    
+    GLfloat omega = 1.0f;
+    GLfloat ddOld = 0.0f;
+    
+    for (GLsizei iteration = 0; iteration < solverIterations; iteration++) {
+        
+        const vec3* q = &jacobiPositions[0];
+        vec3* qPrev = &jacobiPrevious[0];
+        
+        omega = warmUp ? 1.0f : chebyshevOmega(iteration, constraintRadius, omega);
+        
+        // Half the excess length on each particle, as the Gauss-Seidel pass
+        #pragma omp parallel for schedule(static) if (parallelForces())
+        for (GLsizei s = 0; s < NumC; s++) {
+            
+            vec3 deltaP = q[constraints[s].particleA] - q[constraints[s].particleB];
+            GLfloat cLength = length(deltaP);
+            
+            c[s] = (cLength > constraints[s].restLength) ? (deltaP * ((cLength - constraints[s].restLength) / (2.0f * cLength))) : vec3(0);
+        }
+        
+        GLfloat dd = 0.0f;
+        
+        // The new iterate overwrites the previous one, the two are then swapped
+        #pragma omp parallel for schedule(static) if (parallelForces() && !warmUp)
+        for (GLsizei i = 0; i < NumP_XY; i++) {
+            
+            if (!movable[i])
+                continue;
+            
+            vec3 sum = vec3(0);
+            GLuint active = 0;
+            
+            for (GLuint k = adjacencyOffsets[i]; k < adjacencyOffsets[i + 1]; k++) {
+                
+                GLuint ref = adjacency[k];
+                const vec3& correction = c[ref >> 1];
+                
+                if (correction == vec3(0))
+                    continue;
+                
+                if (ref & 1)
+                    sum += correction;
+                else
+                    sum -= correction;
+                
+                active++;
+            }
+            
+            vec3 update = active ? ((CHEBYSHEV_RELAXATION / active) * sum) : vec3(0);
+            
+            if (warmUp)
+                dd += dot(update, update);
+            
+            qPrev[i] = (omega * ((q[i] + update) - qPrev[i])) + qPrev[i];
+        }
+        
+        jacobiPositions.swap(jacobiPrevious);
+        
+        if (warmUp) {
+            
+            if ((ddOld > 0.0f) && (dd > 0.0f))
+                constraintRadius = glm::min(std::sqrt(dd / ddOld), CHEBYSHEV_MAX_RADIUS);
+            
+            ddOld = dd;
+        }
+    }
+    
+    // Verlet is corrected in place, force based schemes through their velocities, XPBD is never passed here
+    vec3* target = (m == VERLET) ? &particles.position[0] : velocity;
+    const vec3* q = &jacobiPositions[0];
+    
+    #pragma omp parallel for schedule(static) if (parallelForces())
+    for (GLsizei i = 0; i < NumP_XY; i++) {
+        
+        if (movable[i])
+            target[i] += q[i] - position[i];
+    }
+}
+
+// Unilateral tethers, a free particle further from its anchor than the geodesic rest distance is moved back onto the sphere
+// around it. The anchors are pinned, so every particle is projected independently and one pass bounds the stretch that
+// the Provot pass only removes over O(height) passes. The correction goes to the same state as the Provot pass, force
+// based schemes also lose their outward velocity along the tether before it is applied
+GLvoid Cloth::constraintsTethers(IntegrationMethod m) {
+    
+    if ((tetherAnchor.size() != (size_t)NumP_XY) || !std::equal(tetherMovable.begin(), tetherMovable.end(), particles.movable.begin()))
+        buildTethers();
+    
+    vec3* position = &particles.position[0];
+    vec3* velocity = &particles.velocity[0];
+    
+    const GLint* anchor = &tetherAnchor[0];
+    const GLfloat* restLength = &tetherLength[0];
+    
+    const GLboolean positional = (m == VERLET);
+    
+    #pragma omp parallel for schedule(static) if (parallelForces())
+    for (GLsizei i = 0; i < NumP_XY; i++) {
+        
+        if (anchor[i] < 0)
+            continue;
+        
+        vec3 deltaP = position[i] - position[anchor[i]];
+        GLfloat cLength = length(deltaP);
+        
+        if (cLength <= restLength[i])
+            continue;
+        
+        vec3 n = deltaP / cLength;
+        vec3 correction = n * (restLength[i] - cLength);
+        
+        if (positional)
+            position[i] += correction;
+        else {
+            
+            velocity[i] -= n * glm::max(dot(velocity[i], n), 0.0f);
+            velocity[i] += correction;
+        }
+    }
+}
+
+// Multi-source Dijkstra from the pinned particles over the springs at their rest lengths, each free particle is tethered to
+// the pinned particle it is reached from, at the geodesic distance
+GLvoid Cloth::buildTethers(void) {
+    
+    typedef std::pair<GLfloat, GLuint> Entry;
+    
+    const GLboolean* movable = &particles.movable[0];
+    
+    tetherMovable.assign(particles.movable.begin(), particles.movable.end());
+    tetherAnchor.assign(NumP_XY, -1);
+    tetherLength.assign(NumP_XY, FLT_MAX);
+    
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > queue;
+    
+    for (GLsizei i = 0; i < NumP_XY; i++) {
+        
+        if (!movable[i]) {
+            
+            tetherAnchor[i] = i;
+            tetherLength[i] = 0.0f;
+            queue.push(Entry(0.0f, i));
+        }
+    }
+    
+    while (!queue.empty()) {
+        
+        Entry top = queue.top();
+        queue.pop();
+        
+        const GLuint i = top.second;
+        
+        if (top.first > tetherLength[i])
+            continue;
+        
+        for (GLuint k = adjacencyOffsets[i]; k < adjacencyOffsets[i + 1]; k++) {
+            
+            const Spring& c = constraints[adjacency[k] >> 1];
+            const GLuint j = (adjacency[k] & 1) ? c.particleA : c.particleB;
+            const GLfloat d = top.first + c.restLength;
+            
+            if (d < tetherLength[j]) {
+                
+                tetherLength[j] = d;
+                tetherAnchor[j] = tetherAnchor[i];
+                queue.push(Entry(d, j));
+            }
+        }
+    }
+    
+    // Pinned particles are not tethered
+    for (GLsizei i = 0; i < NumP_XY; i++) {
+        
+        if (!movable[i])
+            tetherAnchor[i] = -1;
+    }
+}
+
+GLvoid Cloth::setConstraintSolver(ConstraintSolver solver) {
+    
+    constraintSolver = solver;
+    constraintRadius = 0.0f;
+}
+
+// Greedy graph colouring of constraints given as 'arity' particle indices each, the colour chosen is the lowest not yet
+// used by any constraint sharing a particle, colours past MAX_COLOURS - 1 are left in a final batch that must run serially
+GLuint Cloth::greedyColouring(const GLuint* indices, GLuint arity, GLsizei count, std::vector<GLuint>& colours) {
+    
+    std::vector<GLuint64> used(NumP_XY, 0);
+    
+    GLuint numColours = 0;
+    
+    colours.resize(count);
+    
+    for (GLsizei s = 0; s < count; s++) {
+        
+        const GLuint* p = &indices[s * arity];
+        
+        GLuint64 mask = 0;
+        
+        for (GLuint k = 0; k < arity; k++)
+            mask |= used[p[k]];
+        
+        GLuint colour = 0;
+        
+        while ((colour < MAX_COLOURS - 1) && (mask & (GLuint64(1) << colour)))
+            colour++;
+        
+        for (GLuint k = 0; k < arity; k++)
+            used[p[k]] |= (GLuint64(1) << colour);
+        
+        colours[s] = colour;
+        numColours = glm::max(numColours, colour + 1);
+    }
+    
+    return(numColours);
+}
+
+// Groups the spring indices by colour, recording the first entry of each batch, the constraints keep their order
+GLvoid Cloth::buildConstraintBatches(void) {
+    
+    GLsizei NumC = (GLsizei)constraints.size();
+    
+    // Analytic lattice colours are recorded by generateSprings, any other topology is coloured greedily
+    if ((GLsizei)springColours.size() != NumC) {
+        
+        std::vector<GLuint> indices(NumC * 2);
+        
+        for (GLsizei s = 0; s < NumC; s++) {
+            indices[(s * 2) + 0] = constraints[s].particleA;
+            indices[(s * 2) + 1] = constraints[s].particleB;
+        }
+        
+        greedyColouring(&indices[0], 2, NumC, springColours);
+    }
+    
+    GLuint numColours = 0;
+    
+    for (GLsizei s = 0; s < NumC; s++)
+        numColours = glm::max(numColours, springColours[s] + 1);
+    
+    constraintBatches.assign(numColours + 1, 0);
+    
+    for (GLsizei s = 0; s < NumC; s++)
+        constraintBatches[springColours[s] + 1]++;
+    
+    for (GLuint c = 0; c < numColours; c++)
+        constraintBatches[c + 1] += constraintBatches[c];
+    
+    std::vector<GLsizei> fill(constraintBatches.begin(), constraintBatches.end() - 1);
+    
+    batchSprings.resize(NumC);
+    
+    for (GLsizei s = 0; s < NumC; s++)
+        batchSprings[fill[springColours[s]]++] = s;
+    
+    springColours.clear();
+}
+
+// Batches coloured past the greedy colour limit may share particles and are never split across threads
+inline GLboolean Cloth::parallelBatch(GLsizei batch) {
+    return((batch < MAX_COLOURS - 1) && ((constraintBatches[batch + 1] - constraintBatches[batch]) >= PARALLEL_THRESHOLD));
+}
+
+/// INTEGRATION SCHEMES
+
+// Single particle update of the one force evaluation schemes, shared by their integrators and the fused step
+inline GLvoid Cloth::integrateParticle(GLuint i, GLfloat dt, IntegrationMethod m) {
+    
+    vec3 X = particles.position[i];
+    vec3 A = particles.force[i] * particles.invMass[i];
+    
+    switch (m) {
+            
+        case F_EULER: {
+            
+            vec3 V = particles.velocity[i];
+            vec3 Vlast = particles.lastVelocity[i];
+            
+            V = V + (A * dt);
+            X = X + (Vlast * dt);
+            
+            setNewVelocity(i, V);
+            setNewPosition(i, X);
+            break;
+        }
+            
+        case FB_EULER: {
+            
+            vec3 V = particles.velocity[i];
+            
+            V = V + (A * dt);
+            X = X + (V * dt);
+            
+            setNewVelocity(i, V);
+            setNewPosition(i, X);
+            break;
+        }
+            
+        case VERLET: {
+            
+            vec3 Xlast = particles.lastPosition[i];
+            
+            X = X + (X - Xlast) + (A * powf(dt, 2));
+            
+            setNewPosition(i, X);
+            break;
+        }
+            
+        default:
+            break;
+    }
+}
+
+// Jacobsen [2001/ref4], The precursor to position based dynamics formalised in Müller et al. [2006]
+GLvoid Cloth::EXP_Verlet(GLfloat dt) {
+    
+    PROFILE_SCOPE(profiler, PROFILE_VERLET);
+    
+    for (GLsizei i = 0; i < NumP_XY; i++)
+        integrateParticle(i, dt, VERLET);
+}
+
+GLvoid Cloth::EXP_ForwardEuler(GLfloat dt) {
+    
+    PROFILE_SCOPE(profiler, PROFILE_F_EULER);
+    
+    for (GLsizei i = 0; i < NumP_XY; i++)
+        integrateParticle(i, dt, F_EULER);
+}
+
+// Explicit midpoint method, y' = y + dt f(y + dt/2 f(y)), for the state y = (x, v) and f(y) = (v, F(x, v) / m)
+GLvoid Cloth::EXP_RungeKutta2(GLfloat dt) {
+    
+    PROFILE_SCOPE(profiler, PROFILE_RK2_EULER);
+    
+    rkPosition.resize(NumP_XY);
+    rkVelocity.resize(NumP_XY);
+    
+    vec3* position = &particles.position[0];
+    vec3* velocity = &particles.velocity[0];
+    vec3* force = &particles.force[0];
+    const GLfloat* invMass = &particles.invMass[0];
+    const GLboolean* movable = &particles.movable[0];
+    
+    vec3* x0 = &rkPosition[0];
+    vec3* v0 = &rkVelocity[0];
+    const vec3* external = &rkExternal[0];
+    
+    // Midpoint state, the forces of the step are evaluated there
+    #pragma omp parallel for schedule(static) if (parallelForces())
+    for (GLsizei i = 0; i < NumP_XY; i++) {
+        
+        x0[i] = position[i];
+        v0[i] = velocity[i];
         
-        vec3 X = p->getPosition();
-        vec3 Xlast = p->getLPosition();
-        vec3 A = p->getAcceleration();
+        if (movable[i])
+            position[i] = x0[i] + ((dt / 2.0f) * v0[i]);
         
-        X = X + (X - Xlast) + (A * powf(dt, 2));
+        velocity[i] = v0[i] + ((dt / 2.0f) * (force[i] * invMass[i]));
+        force[i] = external[i];
+    }
+    
+    computeForces(dt, RK2_EULER);
+    
+    #pragma omp parallel for schedule(static) if (parallelForces())
+    for (GLsizei i = 0; i < NumP_XY; i++) {
+        
+        particles.lastPosition[i] = x0[i];
+        particles.lastVelocity[i] = v0[i];
         
-        p->setNewPosition(X);
+        if (movable[i])
+            position[i] = x0[i] + (dt * velocity[i]);
+        
+        velocity[i] = v0[i] + (dt * (force[i] * invMass[i]));
     }
 }
 
-GLvoid Cloth::EXP_ForwardEuler(GLfloat dt) {
+// Classical fourth order Runge-Kutta over the state y = (x, v), the first stage's forces are those computed for the step
+// Each stage is a single pass, accumulating its derivative into the weighted sums and setting up the next stage's state
+// & external forces, followed by one computeForces, so a step costs four force evaluations and four passes over the particles
+GLvoid Cloth::EXP_RungeKutta4(GLfloat dt) {
+    
+    PROFILE_SCOPE(profiler, PROFILE_RK4_EULER);
+    
+    rkPosition.resize(NumP_XY);
+    rkVelocity.resize(NumP_XY);
+    rkSumX.resize(NumP_XY);
+    rkSumV.resize(NumP_XY);
+    
+    vec3* position = &particles.position[0];
+    vec3* velocity = &particles.velocity[0];
+    vec3* force = &particles.force[0];
+    const GLfloat* invMass = &particles.invMass[0];
+    const GLboolean* movable = &particles.movable[0];
+    
+    vec3* x0 = &rkPosition[0];
+    vec3* v0 = &rkVelocity[0];
+    vec3* sumX = &rkSumX[0];
+    vec3* sumV = &rkSumV[0];
+    const vec3* external = &rkExternal[0];
+    
+    // Stage weights & the offset of the next stage's state from the start of the step
+    const GLfloat weight[4] = { 1.0f, 2.0f, 2.0f, 1.0f };
+    const GLfloat offset[3] = { dt / 2.0f, dt / 2.0f, dt };
+    
+    for (GLsizei stage = 0; stage < 4; stage++) {
+        
+        const GLfloat w = weight[stage];
+        
+        #pragma omp parallel for schedule(static) if (parallelForces())
+        for (GLsizei i = 0; i < NumP_XY; i++) {
+            
+            vec3 kX = velocity[i];
+            vec3 kV = force[i] * invMass[i];
+            
+            if (stage == 0) {
+                
+                x0[i] = position[i];
+                v0[i] = velocity[i];
+                sumX[i] = kX;
+                sumV[i] = kV;
+            }
+            else {
+                
+                sumX[i] += w * kX;
+                sumV[i] += w * kV;
+            }
+            
+            if (stage < 3) {
+                
+                if (movable[i])
+                    position[i] = x0[i] + (offset[stage] * kX);
+                
+                velocity[i] = v0[i] + (offset[stage] * kV);
+                force[i] = external[i];
+            }
+            else {
+                
+                particles.lastPosition[i] = x0[i];
+                particles.lastVelocity[i] = v0[i];
+                
+                if (movable[i])
+                    position[i] = x0[i] + ((dt / 6.0f) * sumX[i]);
+                
+                velocity[i] = v0[i] + ((dt / 6.0f) * sumV[i]);
+            }
+        }
+        
+        if (stage < 3)
+            computeForces(dt, RK4_EULER);
+    }
+}
+
+GLvoid Cloth::SYM_ForwardBackwardEuler(GLfloat dt) { // Symplectic Euler
+    
+    PROFILE_SCOPE(profiler, PROFILE_FB_EULER);
+    
+    for (GLsizei i = 0; i < NumP_XY; i++)
+        integrateParticle(i, dt, FB_EULER);
+}
+
+// Centre of gravity & torque sums of the IMEX prediction, reduced together in one pass
+struct IMEXMoments {
+    
+    IMEXMoments(GLfloat s = 0.0f) : Xg(s), dTor(s) {
+        
+    }
+    
+    IMEXMoments& operator+=(const IMEXMoments& b) {
+        
+        Xg += b.Xg;
+        dTor += b.dTor;
+        return(*this);
+    }
+    
+    vec3 Xg;
+    vec3 dTor;
+};
+
+// The filter W = (I - H dt^2 / m)^-1 only depends on dt & the mass, one is kept per distinct mass and rebuilt when the time
+// step changes or any particle's mass does, a reorder included
+GLvoid Cloth::buildIMEXFilters(GLfloat dt) {
+    
+    const GLfloat* invMass = &particles.invMass[0];
+    
+    if ((imexDt == dt) && (imexInvMass.size() == (size_t)NumP_XY) && std::equal(imexInvMass.begin(), imexInvMass.end(), invMass))
+        return;
+    
+    imexDt = dt;
+    imexInvMass.assign(invMass, invMass + NumP_XY);
+    
+    std::vector<GLfloat> masses(imexInvMass);
+    std::sort(masses.begin(), masses.end());
+    masses.erase(std::unique(masses.begin(), masses.end()), masses.end());
+    
+    mat3 I = mat3(1); // Identity/Unit Matrix
+    mat3 H = mat3(-1, 1, 0,
+                  1,-2, 1,
+                  0, 1,-1); // Hessian Matrix
+    
+    imexFilter.resize(masses.size());
+    
+    for (size_t c = 0; c < masses.size(); c++) {
+        
+        GLfloat m = 1.0f / masses[c];
+        imexFilter[c] = inverse(I - H * (powf(dt, 2) / m)); // Filter
+    }
+    
+    imexClass.resize(NumP_XY);
+    
+    for (GLsizei i = 0; i < NumP_XY; i++)
+        imexClass[i] = (GLuint)(std::lower_bound(masses.begin(), masses.end(), invMass[i]) - masses.begin());
+}
+
+// Desbrun et al. [1999/ref2], 'Interactive Animation Of Structured Deformable Objects'
+GLvoid Cloth::SYM_ModifiedForwardBackwardEuler(GLfloat dt) { // AKA IMplicit-EXplicit (IMEX) Scheme
+    
+    PROFILE_SCOPE(profiler, PROFILE_MFB_EULER);
+    
+    buildIMEXFilters(dt);
+    pForce.resize(NumP_XY);
+    
+    const vec3* position = &particles.position[0];
+    const vec3* velocity = &particles.velocity[0];
+    const vec3* force = &particles.force[0];
+    const GLfloat* invMass = &particles.invMass[0];
+    
+    const mat3* W = &imexFilter[0];
+    const GLuint* filterClass = &imexClass[0];
+    vec3* Fp = &pForce[0];
+    
+    // Prediction, the predicted forces are stored as the centre of gravity & the torque are reduced, each term runs once
+    IMEXMoments moments = LargeVMReduce(NumP_XY, [&](GLsizei i) {
+        
+        Fp[i] = force[i] * W[filterClass[i]]; // Predicted Force
+        
+        IMEXMoments term(0);
+        term.Xg = position[i];
+        term.dTor = cross(Fp[i], position[i]);
+        
+        return(term);
+    });
+    
+    const vec3 Xg = moments.Xg / (GLfloat)NumP_XY; // Centre of Gravity
+    const vec3 dTor = moments.dTor; // Global Torque
+    
+    // Update & correction of each particle in one pass, the correction reads the updated position
+    #pragma omp parallel for schedule(static) if (parallelForces())
+    for (GLsizei i = 0; i < NumP_XY; i++) {
+        
+        vec3 V = velocity[i];
+        vec3 X = position[i];
+        
+        V = V + (((force[i] + Fp[i]) * dt) * invMass[i]);
+        X = X + (V * dt);
+        
+        vec3 Fc = cross((Xg - X), dTor) * dt; // Corrected Force
+        X = X + Fc * (powf(dt, 2) * invMass[i]);
+        
+        setNewVelocity(i, V);
+        setNewPosition(i, X);
+    }
+}
+
+// Multi-rate Symplectic Euler, the step is split into as many substeps as the highest spring rate and each spring type is
+// evaluated springRates[type] times, evenly spread, its forces held in between. The external forces, gravity & global
+// damping are evaluated once for the step, as are the collision & wind passes run before it
+GLvoid Cloth::SYM_MultiRateEuler(GLfloat dt) {
+    
+    PROFILE_SCOPE(profiler, PROFILE_MULTIRATE);
+    
+    if (springGroups.empty())
+        buildSpringGroups();
+    
+    GLuint substeps = 1;
+    
+    for (GLuint t = 0; t < SPRING_TYPES; t++)
+        substeps = glm::max(substeps, springRates[t]);
+    
+    const GLfloat h = dt / substeps;
+    
+    vec3* position = &particles.position[0];
+    vec3* velocity = &particles.velocity[0];
+    const vec3* force = &particles.force[0];
+    const GLfloat* invMass = &particles.invMass[0];
+    const GLboolean* movable = &particles.movable[0];
+    
+    for (GLuint k = 0; k < substeps; k++) {
+        
+        // A type of rate r is due on the substeps where floor(k r / substeps) steps up, k = 0 included
+        GLboolean due[SPRING_TYPES];
+        
+        for (GLuint t = 0; t < SPRING_TYPES; t++) {
+            
+            due[t] = (((k * springRates[t]) % substeps) < springRates[t]);
+            
+            if (!due[t])
+                continue;
+            
+            SpringGroup& group = springGroups[t];
+            
+            const GLsizei NumS = (GLsizei)group.springs.size();
+            const GLsizei NumBlocks = (NumS + SPRING_BLOCK - 1) / SPRING_BLOCK;
+            
+            #pragma omp parallel for schedule(static) if (parallelForces())
+            for (GLsizei block = 0; block < NumBlocks; block++) {
+                
+                GLsizei first = block * SPRING_BLOCK;
+                GLsizei last = glm::min(first + SPRING_BLOCK, NumS);
+                
+                springKernel.evaluate(&group.springs[0], &materials[0], position, velocity, &group.springForce[0], first, last);
+            }
+        }
+        
+        #pragma omp parallel for schedule(static) if (parallelForces())
+        for (GLsizei i = 0; i < NumP_XY; i++) {
+            
+            vec3 F = force[i];
+            
+            for (GLuint t = 0; t < SPRING_TYPES; t++) {
+                
+                SpringGroup& group = springGroups[t];
+                
+                if (due[t]) {
+                    
+                    vec3 sum = vec3(0);
+                    
+                    for (GLuint j = group.adjacencyOffsets[i]; j < group.adjacencyOffsets[i + 1]; j++) {
+                        
+                        GLuint ref = group.adjacency[j];
+                        
+                        if (ref & 1)
+                            sum -= group.springForce[ref >> 1];
+                        else
+                            sum += group.springForce[ref >> 1];
+                    }
+                    
+                    group.force[i] = sum;
+                }
+                
+                F += group.force[i];
+            }
+            
+            if (k == 0) {
+                
+                particles.lastPosition[i] = position[i];
+                particles.lastVelocity[i] = velocity[i];
+            }
+            
+            velocity[i] += (F * invMass[i]) * h;
+            
+            if (movable[i])
+                position[i] += velocity[i] * h;
+        }
+    }
+}
+
+// Splits the springs by type, keeping their first particle order, with a spring list per particle for each type
+GLvoid Cloth::buildSpringGroups(void) {
+    
+    springGroups.assign(SPRING_TYPES, SpringGroup());
+    
+    for (auto c = constraints.begin(); c != constraints.end(); c++)
+        springGroups[c->material].springs.push_back(*c);
+    
+    for (GLuint t = 0; t < SPRING_TYPES; t++) {
+        
+        SpringGroup& group = springGroups[t];
+        
+        const GLsizei NumS = (GLsizei)group.springs.size();
+        
+        group.adjacencyOffsets.assign(NumP_XY + 1, 0);
+        
+        for (GLsizei s = 0; s < NumS; s++) {
+            
+            group.adjacencyOffsets[group.springs[s].particleA + 1]++;
+            group.adjacencyOffsets[group.springs[s].particleB + 1]++;
+        }
+        
+        for (GLsizei i = 0; i < NumP_XY; i++)
+            group.adjacencyOffsets[i + 1] += group.adjacencyOffsets[i];
+        
+        std::vector<GLuint> fill(group.adjacencyOffsets.begin(), group.adjacencyOffsets.end() - 1);
+        
+        group.adjacency.resize(2 * NumS);
+        
+        for (GLsizei s = 0; s < NumS; s++) {
+            
+            group.adjacency[fill[group.springs[s].particleA]++] = (s << 1);
+            group.adjacency[fill[group.springs[s].particleB]++] = (s << 1) | 1;
+        }
+        
+        group.springForce.assign(NumS, vec3(0));
+        group.force.assign(NumP_XY, vec3(0));
+    }
+}
+
+// Standard Implicit Euler
+GLvoid Cloth::IMP_BackwardEuler(GLfloat dt) {
+    
+    PROFILE_SCOPE(profiler, PROFILE_B_EULER);
+    
+    // (M - dt^2 K) V' = M V + dt F, with K the assembled stiffness Jacobian
+    assembleSystem(dt, B_EULER);
+    prepareSolve();
+    
+    #pragma omp parallel for schedule(static) if (parallelForces())
+    for (GLsizei i = 0; i < NumP_XY; i++) {
+        
+        X[i] = particles.position[i];
+        F[i] = particles.force[i];
+        V[i] = particles.velocity[i];
+    }
+    
+    rhs = (mMat * V) + (dt * F);
+    
+    // The system is symmetric positive definite, solved from the current velocity plus the filtered velocity change of the
+    // last step, the constrained components keep their current velocity
+    if (solverPolicy.warmStart && (dV.size() == NumP_XY))
+        Vnew = V + (sMat * dV);
+    else
+        Vnew = V;
+    
+    solveSystem(Vnew, rhs);
+    
+    dV = Vnew - V;
+    
+    for (GLsizei i = 0; i < NumP_XY; i++) {
+        
+        X[i] += (dt * Vnew[i]);
+        V[i] = Vnew[i];
+        
+        setNewPosition(i, X[i]);
+        setNewVelocity(i, V[i]);
+    }
+}
+
+// Baraff & Witkin [1998], (M - dt ∂F/∂V - dt^2 ∂F/∂X) ΔV = dt (F + dt ∂F/∂X V), damping is implicit as well
+// The system pattern is built once, every step refills the per spring Jacobians and the system blocks in place
+GLvoid Cloth::IMP_ModifiedBackwardEuler(GLfloat dt) {
+    
+    PROFILE_SCOPE(profiler, PROFILE_MB_EULER);
+    
+    assembleSystem(dt, MB_EULER);
+    prepareSolve();
+    
+    if (rhs.size() != NumP_XY)
+        rhs.Resize(NumP_XY);
+    
+    // Constrained components of ΔV are zero, the free components start from the last step's ΔV
+    if (solverPolicy.warmStart && (dV.size() == NumP_XY))
+        dV = sMat * dV;
+    else {
+        
+        dV.Resize(NumP_XY);
+        dV.Clear(GL_FALSE);
+    }
+    
+    const vec3* velocity = &particles.velocity[0];
+    const vec3* force = &particles.force[0];
+    
+    #pragma omp parallel for schedule(static) if (parallelForces())
+    for (GLsizei i = 0; i < NumP_XY; i++) {
+        
+        // Row i of ∂F/∂X V, gathered over the particle's springs
+        vec3 Kv = vec3(0);
+        
+        for (GLuint k = adjacencyOffsets[i]; k < adjacencyOffsets[i + 1]; k++) {
+            
+            GLuint ref = adjacency[k];
+            const Spring& c = constraints[ref >> 1];
+            
+            GLuint j = (ref & 1) ? c.particleA : c.particleB;
+            
+            Kv += kMat[ref >> 1] * (velocity[i] - velocity[j]);
+        }
+        
+        rhs[i] = dt * (force[i] + (dt * Kv));
+    }
+    
+    solveSystem(dV, rhs);
+    
+    #pragma omp parallel for schedule(static) if (parallelForces())
+    for (GLsizei i = 0; i < NumP_XY; i++) {
+        
+        vec3 vNew = velocity[i] + dV[i];
+        
+        setNewPosition(i, particles.position[i] + (dt * vNew));
+        setNewVelocity(i, vNew);
+    }
+}
+
+// Bouaziz et al. [2014], the mass-spring form of Liu et al. [2013], 'Fast Simulation of Mass-Spring Systems'
+// Each local step projects every spring onto its rest length, the global step then solves (M / dt^2 + L) x = M / dt^2 y
+// + sum w A^T p with the constant matrix factored once, so a step costs PROJECTIVE_ITERATIONS triangular solves. Spring
+// damping is not modelled, global damping is part of the external forces
+GLvoid Cloth::IMP_ProjectiveDynamics(GLfloat dt) {
+    
+    PROFILE_SCOPE(profiler, PROFILE_PROJECTIVE);
     
-    for (auto p = particles.begin(); p != particles.end(); p++) {
+    const GLboolean* movable = &particles.movable[0];
+    
+    // Refactored only when the time step, the stiffness or the pinned particles change
+    if (projectiveStale || (dt != projectiveDt) || (projectiveSystem.getRows() != NumP_XY) ||
+        !std::equal(projectiveMovable.begin(), projectiveMovable.end(), particles.movable.begin()))
+        factorProjective(dt);
+    
+    if (projectiveSystem.getRows() != NumP_XY)
+        return;
+    
+    const GLsizei NumC = (GLsizei)constraints.size();
+    
+    projectiveInertia.resize(NumP_XY);
+    projectivePositions.resize(NumP_XY);
+    springProjection.resize(NumC);
+    
+    const vec3* position = &particles.position[0];
+    const vec3* velocity = &particles.velocity[0];
+    const vec3* force = &particles.force[0];
+    const GLfloat* invMass = &particles.invMass[0];
+    
+    vec3* y = &projectiveInertia[0];
+    vec3* q = &projectivePositions[0];
+    vec3* p = &springProjection[0];
+    
+    const GLfloat dt2 = dt * dt;
+    
+    // Inertial positions, also the first iterate
+    #pragma omp parallel for schedule(static) if (parallelForces())
+    for (GLsizei i = 0; i < NumP_XY; i++) {
+        
+        y[i] = movable[i] ? (position[i] + (dt * velocity[i]) + (dt2 * invMass[i] * force[i])) : position[i];
+        q[i] = y[i];
+    }
+    
+    for (GLsizei iteration = 0; iteration < PROJECTIVE_ITERATIONS; iteration++) {
+        
+        // Local step, springs are projected independently
+        #pragma omp parallel for schedule(static) if (parallelForces())
+        for (GLsizei s = 0; s < NumC; s++) {
+            
+            const Spring& c = constraints[s];
+            
+            vec3 deltaP = q[c.particleA] - q[c.particleB];
+            GLfloat sLength = length(deltaP);
+            
+            p[s] = (sLength > 0.0f) ? (deltaP * (c.restLength / sLength)) : vec3(0);
+        }
+        
+        // Global step right hand side, gathered per particle over its springs, pinned neighbours are known positions
+        #pragma omp parallel for schedule(static) if (parallelForces())
+        for (GLsizei i = 0; i < NumP_XY; i++) {
+            
+            if (!movable[i]) {
+                
+                q[i] = position[i];
+                continue;
+            }
+            
+            vec3 b = (y[i] / (invMass[i] * dt2));
+            
+            for (GLuint k = adjacencyOffsets[i]; k < adjacencyOffsets[i + 1]; k++) {
+                
+                GLuint ref = adjacency[k];
+                const Spring& c = constraints[ref >> 1];
+                const GLfloat w = materials[c.material].Ks;
+                
+                GLuint j = (ref & 1) ? c.particleA : c.particleB;
+                
+                if (!movable[j])
+                    b += w * position[j];
+                
+                if (ref & 1)
+                    b -= w * p[ref >> 1];
+                else
+                    b += w * p[ref >> 1];
+            }
+            
+            q[i] = b;
+        }
+        
+        projectiveSystem.solve(q, q);
+    }
+    
+    #pragma omp parallel for schedule(static) if (parallelForces())
+    for (GLsizei i = 0; i < NumP_XY; i++) {
+        
+        vec3 vNew = (q[i] - position[i]) / dt;
+        
+        setNewPosition(i, q[i]);
+        setNewVelocity(i, vNew);
+    }
+}
+
+
+// Small steps, Macklin et al. [2019], 'Small Steps in Physics Simulation'. The step is split into the fewest substeps of no
+// more than XPBD_MAX_SUBSTEP, each a single Gauss-Seidel sweep over the constraint batches with the multipliers restarted
+// The compliance is scaled by the substep, so a single sweep stays close to the converged solve while the substeps are
+// short, the remaining dependence on the substep length is bounded by the cap rather than growing with dt
+GLvoid Cloth::PBD_ExtendedPositionBased(GLfloat dt) {
+    
+    PROFILE_SCOPE(profiler, PROFILE_XPBD);
+    
+    if (dConstraints.size() == 0)
+        buildPositionConstraints();
+    
+    xpbdPrevious.resize(NumP_XY);
+    
+    vec3* position = &particles.position[0];
+    vec3* velocity = &particles.velocity[0];
+    const vec3* force = &particles.force[0];
+    const GLfloat* invMass = &particles.invMass[0];
+    const GLboolean* movable = &particles.movable[0];
+    
+    const GLuint* pA = dConstraints.particleA.data();
+    const GLuint* pB = dConstraints.particleB.data();
+    const GLfloat* restLength = dConstraints.restLength.data();
+    const GLfloat* compliance = dConstraints.compliance.data();
+    const GLfloat* damping = dConstraints.damping.data();
+    GLfloat* lambda = dConstraints.lambda.data();
+    
+    vec3* xPrev = &xpbdPrevious[0];
+    
+    const GLsizei substeps = glm::max(1, (GLsizei)std::ceil(dt / XPBD_MAX_SUBSTEP));
+    const GLfloat h = dt / substeps;
+    const GLfloat invH = 1.0f / h;
+    const GLfloat invH2 = invH * invH;
+    
+    for (GLsizei substep = 0; substep < substeps; substep++) {
+        
+        // Prediction, the external forces of the step are held over its substeps, damping is left to the velocity update
+        #pragma omp parallel for schedule(static) if (parallelForces())
+        for (GLsizei i = 0; i < NumP_XY; i++) {
+            
+            if (substep == 0) {
+                
+                particles.lastPosition[i] = position[i];
+                particles.lastVelocity[i] = velocity[i];
+            }
+            
+            xPrev[i] = position[i];
+            
+            // The velocity is predicted first, so increments below the rounding of a position still accumulate
+            if (movable[i]) {
+                
+                velocity[i] += (h * invMass[i]) * force[i];
+                position[i] += h * velocity[i];
+            }
+        }
         
-        vec3 V = p->getVelocity();
-        vec3 Vlast = p->getLVelocity();
-        vec3 X = p->getPosition();
-        vec3 A = p->getAcceleration();
+        std::fill(dConstraints.lambda.begin(), dConstraints.lambda.end(), 0.0f);
         
-        V = V + (A * dt);
-        X = X + (Vlast * dt);
+        // No two constraints of a batch share a particle, so each batch is projected in parallel without atomics
+        for (GLsizei batch = 0; batch < dConstraints.getNumBatches(); batch++) {
+            
+            const GLsizei first = dConstraints.batches[batch];
+            const GLsizei last = dConstraints.batches[batch + 1];
+            
+            #pragma omp parallel for schedule(static) if ((batch < MAX_COLOURS - 1) && ((last - first) >= PARALLEL_THRESHOLD))
+            for (GLsizei k = first; k < last; k++) {
+                
+                const GLuint a = pA[k];
+                const GLuint b = pB[k];
+                
+                const GLfloat wA = movable[a] ? invMass[a] : 0.0f;
+                const GLfloat wB = movable[b] ? invMass[b] : 0.0f;
+                
+                vec3 deltaP = position[a] - position[b];
+                GLfloat cLength = length(deltaP);
+                
+                if (((wA + wB) == 0.0f) || (cLength == 0.0f))
+                    continue;
+                
+                vec3 n = deltaP / cLength;
+                
+                // C = |xa - xb| - l, with alpha~ = alpha / h^2 & gamma = alpha beta / h, Macklin et al. [2016] Eq. 26
+                // dLambda = (-C - alpha~ lambda - gamma dC/dx (x - x_n)) / ((1 + gamma)(wA + wB) + alpha~)
+                const GLfloat alpha = compliance[k] * invH2;
+                const GLfloat gamma = damping[k] * invH;
+                const GLfloat cDot = dot(n, (position[a] - xPrev[a]) - (position[b] - xPrev[b]));
+                const GLfloat dLambda = (-(cLength - restLength[k]) - (alpha * lambda[k]) - (gamma * cDot)) / (((1.0f + gamma) * (wA + wB)) + alpha);
+                
+                lambda[k] += dLambda;
+                deltaP = n * dLambda;
+                
+                position[a] += wA * deltaP;
+                position[b] -= wB * deltaP;
+            }
+        }
         
-        p->setNewVelocity(V);
-        p->setNewPosition(X);
+        // The projection's correction, x - (x_n + h v), is added to the predicted velocity rather than rederiving the
+        // velocity from x - x_n. Global damping, implicit so no substep length can overshoot, v' = v + h M^-1 GD v'
+        #pragma omp parallel for schedule(static) if (parallelForces())
+        for (GLsizei i = 0; i < NumP_XY; i++) {
+            
+            const vec3 correction = position[i] - (xPrev[i] + (h * velocity[i]));
+            
+            velocity[i] = (velocity[i] + (correction * invH)) / (1.0f - (h * invMass[i] * GlobalDamping));
+        }
     }
 }
 
-GLvoid Cloth::EXP_RungeKutta2(GLfloat dt) {
+// The distance constraints of the springs, structural & shear, and the bending constraints of the bend springs spanning two
+// particles, copied in batch order so each batch is contiguous. Springs without stiffness are left out
+GLvoid Cloth::buildPositionConstraints(void) {
     
-    for (auto p = particles.begin(); p != particles.end(); p++) {
-        
-        vec3 V = p->getVelocity();
-        vec3 Vlast = p->getLVelocity();
-        vec3 X = p->getPosition();
-        vec3 A = p->getAcceleration();
-        
-        V = V + ((dt/2.0f) * A);
-        X = X + dt * Vlast;
+    const GLsizei numBatches = (GLsizei)constraintBatches.size() - 1;
+    
+    dConstraints.clear();
+    dConstraints.batches.assign(1, 0);
+    
+    GLsizei count = 0;
+    
+    for (GLsizei k = 0; k < (GLsizei)batchSprings.size(); k++) {
         
-        p->setNewVelocity(V);
-        p->setNewPosition(X);
+        if (materials[constraints[batchSprings[k]].material].Ks > 0.0f)
+            count++;
     }
     
-    computeForces();
+    dConstraints.resize(count);
+    count = 0;
     
-    for (auto p = particles.begin(); p != particles.end(); p++) {
-        
-        vec3 V = p->getVelocity();
-        vec3 Vlast = p->getLVelocity();
-        vec3 X = p->getPosition();
-        vec3 A = p->getAcceleration();
+    for (GLsizei batch = 0; batch < numBatches; batch++) {
         
-        V = V + (dt * A);
-        X = X + dt * Vlast;
+        for (GLsizei k = constraintBatches[batch]; k < constraintBatches[batch + 1]; k++) {
+            
+            const Spring& c = constraints[batchSprings[k]];
+            const GLfloat Ks = materials[c.material].Ks;
+            
+            if (Ks <= 0.0f)
+                continue;
+            
+            dConstraints.particleA[count] = c.particleA;
+            dConstraints.particleB[count] = c.particleB;
+            dConstraints.restLength[count] = c.restLength;
+            dConstraints.compliance[count] = 1.0f / Ks;
+            dConstraints.damping[count] = glm::max(-materials[c.material].Kd, 0.0f) / Ks;
+            count++;
+        }
         
-        p->setNewVelocity(V);
-        p->setNewPosition(X);
+        dConstraints.batches.push_back(count);
     }
 }
-// TODO: Optimise RK4 Implementation, Method should be fast however it is the slowest of all integration schemes
-GLvoid Cloth::EXP_RungeKutta4(GLfloat dt) {
-    
-    // Initialisation
-    for (auto p = particles.begin(); p != particles.end(); p++)
-        RK_Stepper(*p, (dt / 2.0f), (1 / 6.0f));
-    
-    computeForces();
+
+// A = M - dt^2 K for Backward Euler, A = M - dt D - dt^2 K for Modified Backward Euler, with D the damping Jacobian
+// The pattern is built on the first implicit step, each row gathers the Jacobians of its own springs so rows assemble independently
+GLvoid Cloth::assembleSystem(GLfloat dt, IntegrationMethod m) {
     
-    for (auto p = particles.begin(); p != particles.end(); p++)
-        RK_Stepper(*p, (dt / 2.0f), (1 / 3.0f));
+    if (systemMatrix.getRows() != NumP_XY)
+        systemMatrix.build(NumP_XY, constraints);
     
-    computeForces();
+    systemMatrix.setZero();
     
-    for (auto p = particles.begin(); p != particles.end(); p++)
-        RK_Stepper(*p, dt, (1 / 3.0f));
+    // The Chebyshev backend re-estimates its spectral radius for a new time step
+    if (dt != jacobiRadiusDt) {
+        
+        jacobiRadius = 0.0f;
+        jacobiRadiusDt = dt;
+    }
     
-    computeForces();
+    const GLfloat dt2 = dt * dt;
+    const GLboolean damped = (m == MB_EULER);
     
-    for (auto p = particles.begin(); p != particles.end(); p++)
-        RK_Stepper(*p, dt, (1 / 6.0f));
+    // Global damping, ∂F/∂V = GD I on every particle
+    const mat3 globalDamping = damped ? (dt * GlobalDamping) * mat3(1) : mat3(0);
     
-    // Integration
-    for (auto p = particles.begin(); p != particles.end(); p++) {
+    #pragma omp parallel for schedule(static) if (parallelForces())
+    for (GLsizei i = 0; i < NumP_XY; i++) {
         
-        vec3 V = p->getVelocity();
-        vec3 X = p->getPosition();
-        vec3 Fs = sForce[p->getIndex()];
-        vec3 Vs = sVelocity[p->getIndex()];
+        mat3 diagonal = mMat[i] - globalDamping;
         
-        V = V + Fs;
-        X = X + Vs;
+        for (GLuint k = adjacencyOffsets[i]; k < adjacencyOffsets[i + 1]; k++) {
+            
+            GLuint ref = adjacency[k];
+            mat3 J = dt2 * kMat[ref >> 1];
+            
+            if (damped)
+                J += dt * dMat[ref >> 1];
+            
+            // K_aa = K_bb = J, K_ab = K_ba = -J
+            diagonal -= J;
+            systemMatrix.block(systemMatrix.getSpringBlock(ref >> 1, ref & 1)) += J;
+        }
         
-        p->setNewVelocity(V);
-        p->setNewPosition(X);
+        systemMatrix.block(systemMatrix.getDiagonal(i)) = diagonal;
     }
 }
 
-GLvoid Cloth::SYM_ForwardBackwardEuler(GLfloat dt) { // Symplectic Euler
+// Constraint filter & block Jacobi preconditioner of the assembled system, see SolvePCCG
+GLvoid Cloth::prepareSolve(void) {
     
-    for (auto p = particles.begin(); p != particles.end(); p++) {
+    if (sMat.size() != NumP_XY) {
         
-        vec3 V = p->getVelocity();
-        vec3 X = p->getPosition();
-        vec3 A = p->getAcceleration();
+        sMat.Resize(NumP_XY);
+        pMat.Resize(NumP_XY);
+    }
+    
+    const GLboolean* movable = &particles.movable[0];
+    const GLboolean* collision = &particles.collision[0];
+    const vec3* contactNormal = &particles.contactNormal[0];
+    
+    #pragma omp parallel for schedule(static) if (parallelForces())
+    for (GLsizei i = 0; i < NumP_XY; i++) {
         
-        V = V + (A * dt);
-        X = X + (V * dt);
+        // A pinned particle has no free direction, a colliding particle may only move within its contact plane
+        if (!movable[i])
+            sMat[i] = mat3(0);
+        else if (collision[i])
+            sMat[i] = mat3(1) - outerProduct(contactNormal[i], contactNormal[i]);
+        else
+            sMat[i] = mat3(1);
         
-        p->setNewVelocity(V);
-        p->setNewPosition(X);
+        // The inverse of each diagonal block
+        pMat[i] = inverse(systemMatrix.block(systemMatrix.getDiagonal(i)));
     }
 }
 
-// Desbrun et al. [1999/ref2], 'Interactive Animation Of Structured Deformable Objects'
-GLvoid Cloth::SYM_ModifiedForwardBackwardEuler(GLfloat dt) { // AKA IMplicit-EXplicit (IMEX) Scheme
- 
-    vec3 Xg = vec3(0); // Centre of Gravity
-    vec3 dTor = vec3(0); // Global Torque
-    vec3 Fc = vec3(0); // Corrected Force
+GLvoid Cloth::setSolverPolicy(const SolverPolicy& policy) {
     
-    // Prediction
-    for (auto p = particles.begin(); p != particles.end(); p++) {
-        
-        GLfloat m = p->getMass();
-        
-        vec3 Fp = vec3(0);
-        vec3 F = p->getForce();
-        vec3 X = p->getPosition();
-        
-        mat3 I = mat3(1); // Identity/Unit Matrix
-        mat3 H = mat3(-1, 1, 0,
-                      1,-2, 1,
-                      0, 1,-1); // Hessian Matrix
-        
-        mat3 W = inverse(I - H * (powf(dt, 2) / m)); // Filter
-        
-        Fp = Fp + F * W; // Predicted Force
-        Xg = Xg + X;
-        
-        pForce.push_back(Fp);
-    }
+    solverPolicy = policy;
+    
+    SolverStats stats = { 0, 0, 0.0f, GL_FALSE };
+    solverStats = stats;
+    solverHistoryCount = 0;
+    solverHistoryNext = 0;
+}
+
+const Cloth::SolverPolicy& Cloth::getSolverPolicy(void) const {
+    return(solverPolicy);
+}
+
+const Cloth::SolverStats& Cloth::getSolverStats(void) const {
+    return(solverStats);
+}
+
+// Iteration cap of the next solve, twice the most any recent solve needed, a solve stopped by its cap doubles the next cap
+GLsizei Cloth::solverBudget(GLsizei rows) const {
     
-    Xg /= NumP_XY;
+    GLsizei cap = (solverPolicy.maxIterations > 0) ? solverPolicy.maxIterations : (3 * rows);
     
-    for (auto p = particles.begin(); p != particles.end(); p++) {
-        
-        vec3 Fp = pForce[p->getIndex()];
-        vec3 X = p->getPosition();
-        
-        dTor = dTor + cross(Fp, X);
-    }
+    if (!solverPolicy.adaptiveBudget || !solverHistoryCount)
+        return(cap);
     
-    for (auto p = particles.begin(); p != particles.end(); p++) {
-        
-        GLfloat m = p->getMass();
-        
-        vec3 V = p->getVelocity();
-        vec3 X = p->getPosition();
-        vec3 F = p->getForce();
-        vec3 Fp = pForce[p->getIndex()];
-        
-        V = V + ((((F + Fp) * dt) / m));
-        X = X + (V * dt);
-        
-        p->setNewVelocity(V);
-        p->setNewPosition(X);
-    }
+    GLsizei recent = *std::max_element(solverHistory, solverHistory + solverHistoryCount);
     
-    // Correction
-    for (auto p = particles.begin(); p != particles.end(); p++) {
-        
-        GLfloat m = p->getMass();
-        vec3 X = p->getPosition();
-        
-        Fc = cross((Xg - X), dTor) * dt; // Corrected Force
-        X = X + Fc * (powf(dt, 2) / m);
-        
-        p->setNewPosition(X);
-    }
+    return(glm::min(cap, (2 * recent) + 2));
 }
 
-// Standard Implicit Euler
-GLvoid Cloth::IMP_BackwardEuler(GLfloat dt) {
+// rr & bb are the squared residual and right hand side in the stopping norm
+GLvoid Cloth::recordSolve(GLsizei iterations, GLsizei budget, GLfloat rr, GLfloat bb) {
+    
+    solverStats.iterations = iterations;
+    solverStats.budget = budget;
+    solverStats.residual = (bb > 0) ? std::sqrt(rr / bb) : 0;
+    solverStats.converged = (rr <= ((solverPolicy.tolerance * solverPolicy.tolerance) * bb));
+    
+    // The frame's totals, advanceFrame resets them so several steps per frame are all counted
+    stepStats.solves++;
+    stepStats.iterations += iterations;
+    stepStats.maxIterations = glm::max(stepStats.maxIterations, iterations);
+    stepStats.residual += solverStats.residual;
+    stepStats.unconverged += solverStats.converged ? 0 : 1;
+    
+    solverHistory[solverHistoryNext] = iterations;
+    solverHistoryNext = (solverHistoryNext + 1) % SOLVER_HISTORY;
+    solverHistoryCount = glm::min(solverHistoryCount + 1, SOLVER_HISTORY);
+}
+
+// Solves the assembled system with the policy's backend, see prepareSolve
+GLvoid Cloth::solveSystem(LargeVM<vec3>& x, const LargeVM<vec3>& b) {
     
-    // TODO: Extended Task, integrate LargeVM and Particle classes more seamlessly
+    switch (solverPolicy.backend) {
+            
+        case PCCG:
+            SolvePCCG(systemMatrix, x, b, sMat, pMat);
+            break;
+            
+        case MULTIGRID_V:
+        case MULTIGRID_W:
+            SolveMultigrid(systemMatrix, x, b, sMat, pMat);
+            break;
+            
+        case CHEBYSHEV_JACOBI:
+            SolveChebyshev(systemMatrix, x, b, sMat, pMat);
+            break;
+    }
+}
+
+// Factors M / dt^2 + L for Projective Dynamics, L = sum Ks A^T A over the springs, one scalar row per particle shared by the
+// three coordinates. Pinned rows are reduced to the identity and their couplings moved to the right hand side, the rows
+// are eliminated in nested dissection order over the grid
+GLvoid Cloth::factorProjective(GLfloat dt) {
     
-    GLfloat tMass = 0;
-    mat3 I = mat3(1); // Identity Matrix
+    const GLboolean* movable = &particles.movable[0];
+    const GLfloat* invMass = &particles.invMass[0];
     
-    for (auto p = particles.begin(); p != particles.end(); p++) {
-        
-        X[p->getIndex()] = p->getPosition();
-        F[p->getIndex()] = p->getForce();
-        V[p->getIndex()] = p->getVelocity();
-        
-        tMass += p->getMass();
-    }
+    const GLfloat invDt2 = 1.0f / (dt * dt);
     
-    //mMat = (tMass / NumP_XY) * mMat;
+    std::vector<GLuint> rowOffsets(NumP_XY + 1, 0);
     
-    LargeVM<mat3> A = mMat - (pow(dt, 2)*kMat);
-    LargeVM<vec3> b = (mMat* V) + (dt * F);
+    for (GLsizei i = 0; i < NumP_XY; i++)
+        rowOffsets[i + 1] = rowOffsets[i] + 1 + (adjacencyOffsets[i + 1] - adjacencyOffsets[i]);
     
-    //SolveCG(A, Vnew, b);
-    SolveGD(A, Vnew, b);
-
+    std::vector<GLuint> columns(rowOffsets[NumP_XY]);
+    std::vector<GLfloat> values(rowOffsets[NumP_XY]);
     
-    for (auto p = particles.begin(); p != particles.end(); p++) {
+    for (GLsizei i = 0; i < NumP_XY; i++) {
         
-        GLsizei ind = p->getIndex();
+        GLuint e = rowOffsets[i];
+        GLfloat diagonal = movable[i] ? (invDt2 / invMass[i]) : 1.0f;
         
-        X[ind] += (dt * Vnew[ind]);
-        V[ind] = Vnew[ind];
+        for (GLuint k = adjacencyOffsets[i]; k < adjacencyOffsets[i + 1]; k++) {
+            
+            GLuint ref = adjacency[k];
+            const Spring& c = constraints[ref >> 1];
+            const GLfloat w = materials[c.material].Ks;
+            
+            GLuint j = (ref & 1) ? c.particleA : c.particleB;
+            
+            if (movable[i])
+                diagonal += w;
+            
+            columns[++e] = j;
+            values[e] = (movable[i] && movable[j]) ? -w : 0.0f;
+        }
         
-        p->setNewPosition(X[ind]);
-        p->setNewVelocity(V[ind]);
+        columns[rowOffsets[i]] = i;
+        values[rowOffsets[i]] = diagonal;
     }
-}
-
-GLvoid Cloth::IMP_ModifiedBackwardEuler(GLfloat dt) {
     
-    // TODO: Baraff & Witkin [1998] Implicit Integration Scheme
-}
-
-// Supporting Integration Functions
-GLvoid Cloth::RK_Stepper(Particle& p, GLfloat dTS, GLfloat fc) {
+    std::vector<GLuint> order;
+    order.reserve(NumP_XY);
     
-    vec3 Fs, Vs;
-    vec3 V = p.getVelocity();
-    vec3 A = p.getAcceleration();
+    dissect(0, 0, NumPX + 1, NumPY + 1, NumPX + 1, order);
     
-    Fs = A * dTS;
-    Vs = V * dTS * fc;
+    for (GLsizei k = 0; k < NumP_XY; k++)
+        order[k] = gridToParticle[order[k]];
     
-    sForce.push_back(Fs);
-    sVelocity.push_back(Vs);
+    projectiveSystem.factor(NumP_XY, rowOffsets, columns, values, order);
+    
+    projectiveDt = dt;
+    projectiveStale = GL_FALSE;
+    projectiveMovable.assign(particles.movable.begin(), particles.movable.end());
 }
 
-GLvoid Cloth::SolveGD(LargeVM<mat3> A, LargeVM<vec3>& x, LargeVM<vec3> b) {
+// Without a preconditioner both stopping criteria reduce to the relative residual
+GLvoid Cloth::SolveGD(const BlockSparseMatrix& A, LargeVM<vec3>& x, const LargeVM<vec3>& b) {
     
     // NOTE, operators are overloaded by LargeVM
     
-    LargeVM<vec3> r = b - (A * x);
-    LargeVM<vec3> q;
+    LargeVM<vec3>& r = solverWork[0];
+    LargeVM<vec3>& q = solverWork[2];
+    
+    r = b - (A * x);
     
     GLfloat alpha;
-   
+    
     GLfloat del = dot(r, r);
-    GLfloat del0 = del;
+    GLfloat bb = dot(b, b);
     
-    GLfloat eTol = std::pow(1*10, -10); // Error tolerance
-    GLsizei iterMax = 10; // maximum iterations
+    const GLfloat tol2 = solverPolicy.tolerance * solverPolicy.tolerance;
+    const GLsizei budget = solverBudget(A.getRows());
     GLsizei i = 0;
     
-    while ((del > (std::pow(eTol, 2) * del0)) && (i < iterMax)) {
+    while ((del > (tol2 * bb)) && (i < budget)) {
         
         q = A * r;
         
@@ -772,28 +2538,31 @@ GLvoid Cloth::SolveGD(LargeVM<mat3> A, LargeVM<vec3>& x, LargeVM<vec3> b) {
         i++;
     }
     
-    
+    recordSolve(i, budget, del, bb);
 }
 
-GLvoid Cloth::SolveCG(LargeVM<mat3> A, LargeVM<vec3>& x, LargeVM<vec3> b) {
+GLvoid Cloth::SolveCG(const BlockSparseMatrix& A, LargeVM<vec3>& x, const LargeVM<vec3>& b) {
     
     // NOTE, operators are overloaded by LargeVM
     
-    LargeVM<vec3> r = b - (A * x);
-    LargeVM<vec3> d = r;
-    LargeVM<vec3> q;
+    LargeVM<vec3>& r = solverWork[0];
+    LargeVM<vec3>& d = solverWork[1];
+    LargeVM<vec3>& q = solverWork[2];
+    
+    r = b - (A * x);
+    d = r;
     
     GLfloat alpha, beta;
     
     GLfloat delOld;
     GLfloat delNew = dot(r, r); // 'dot' here is not directly the same as glm::dot, but a function of LargeVM
-    GLfloat del0 = delNew;
+    GLfloat bb = dot(b, b);
     
-    GLfloat eTol = std::pow(1*10, -10); // Error tolerance
-    GLsizei iterMax = 10; // maximum iterations
+    const GLfloat tol2 = solverPolicy.tolerance * solverPolicy.tolerance;
+    const GLsizei budget = solverBudget(A.getRows());
     GLsizei i = 0;
     
-    while ((delNew > (std::pow(eTol, 2) * del0)) && (i < iterMax)) { // iterate until (Ax = b is satisfied) or (iterMax is met)
+    while ((delNew > (tol2 * bb)) && (i < budget)) { // iterate until (Ax = b is satisfied) or (the budget is met)
         
         q = A * d;
         
@@ -810,55 +2579,247 @@ GLvoid Cloth::SolveCG(LargeVM<mat3> A, LargeVM<vec3>& x, LargeVM<vec3> b) {
         
         i++;
     }
+    
+    recordSolve(i, budget, delNew, bb);
+}
+
+// Baraff & Witkin [1998], Conjugate Gradient restricted by the filter S to the unconstrained directions of each particle
+// The constrained components of x keep their initial values, iterations continue until the residual meets the policy's
+// stopping criterion or the iteration budget is spent, see SolverPolicy
+GLvoid Cloth::SolvePCCG(const BlockSparseMatrix& A, LargeVM<vec3>& x, const LargeVM<vec3>& b, const LargeVM<mat3>& S, const LargeVM<mat3>& P_inv) {
+    
+    // NOTE, operators are overloaded by LargeVM
+    
+    LargeVM<vec3>& r = solverWork[0];
+    LargeVM<vec3>& c = solverWork[1];
+    LargeVM<vec3>& q = solverWork[2];
+    LargeVM<vec3>& s = solverWork[3];
+    
+    const GLboolean energy = (solverPolicy.stopping == ENERGY_NORM);
+    
+    // Filtered right hand side, q is free until the first iteration
+    q = S * b;
+    GLfloat bb = energy ? dot(q, P_inv * q) : dot(q, q);
+    
+    r = S * (b - (A * x));
+    c = S * (P_inv * r);
+    
+    GLfloat delNew = dot(r, c);
+    GLfloat delOld;
+    GLfloat rr = energy ? delNew : dot(r, r);
+    
+    GLfloat alpha;
+    
+    const GLfloat tol2 = solverPolicy.tolerance * solverPolicy.tolerance;
+    const GLsizei budget = solverBudget(A.getRows());
+    GLsizei i = 0;
+    
+    while ((rr > (tol2 * bb)) && (i < budget)) {
+        
+        q = S * (A * c);
+        
+        alpha = delNew / dot(c, q);
+        
+        x = x + alpha * c;
+        r = r - alpha * q;
+        
+        s = P_inv * r;
+        
+        delOld = delNew;
+        delNew = dot(r, s);
+        rr = energy ? delNew : dot(r, r);
+        
+        c = S * (s + ((delNew / delOld) * c));
+        
+        i++;
+    }
+    
+    recordSolve(i, budget, rr, bb);
+}
+
+// Multigrid iteration, each iteration corrects x by one cycle on the filtered residual, see Multigrid.hpp
+// The number of cycles needed stays near constant as the lattice is refined, P_inv only serves the energy norm stopping criterion
+GLvoid Cloth::SolveMultigrid(const BlockSparseMatrix& A, LargeVM<vec3>& x, const LargeVM<vec3>& b, const LargeVM<mat3>& S, const LargeVM<mat3>& P_inv) {
+    
+    if (multigrid.getRows() != A.getRows())
+        multigrid.build(NumPX + 1, NumPY + 1, gridToParticle, particleToGrid);
+    
+    multigrid.setup(A, S.data());
+    
+    const Multigrid::Cycle cycle = (solverPolicy.backend == MULTIGRID_W) ? Multigrid::W_CYCLE : Multigrid::V_CYCLE;
+    
+    LargeVM<vec3>& r = solverWork[0];
+    LargeVM<vec3>& e = solverWork[1];
+    LargeVM<vec3>& q = solverWork[2];
+    
+    const GLboolean energy = (solverPolicy.stopping == ENERGY_NORM);
+    
+    q = S * b;
+    GLfloat bb = energy ? dot(q, P_inv * q) : dot(q, q);
+    
+    r = S * (b - (A * x));
+    GLfloat rr = energy ? dot(r, P_inv * r) : dot(r, r);
+    
+    if (e.size() != A.getRows())
+        e.Resize(A.getRows());
+    
+    const GLfloat tol2 = solverPolicy.tolerance * solverPolicy.tolerance;
+    const GLsizei budget = solverBudget(A.getRows());
+    GLsizei i = 0;
+    
+    while ((rr > (tol2 * bb)) && (i < budget)) {
+        
+        multigrid.cycle(cycle, r.data(), &e[0]);
+        
+        x = x + e;
+        r = S * (b - (A * x));
+        
+        rr = energy ? dot(r, P_inv * r) : dot(r, r);
+        
+        i++;
+    }
+    
+    recordSolve(i, budget, rr, bb);
 }
 
-GLvoid Cloth::SolvePCCG(LargeVM<mat3> A, LargeVM<vec3>& x, LargeVM<vec3> b, LargeVM<vec3> P, LargeVM<vec3> P_inv) {
+// Block Jacobi, x' = x + S P^-1 r, accelerated by the Chebyshev semi-iterative method, x_k+1 = w_k+1 (x' - x_k-1) + x_k-1
+// The spectral radius of the Jacobi iteration is measured by a few plain iterations, from the ratio of successive corrections,
+// and kept until the time step or stiffness change. Iterations are independent per particle & only every CHEBYSHEV_CHECK-th
+// computes the residual norm
+GLvoid Cloth::SolveChebyshev(const BlockSparseMatrix& A, LargeVM<vec3>& x, const LargeVM<vec3>& b, const LargeVM<mat3>& S, const LargeVM<mat3>& P_inv) {
+    
+    LargeVM<vec3>& r = solverWork[0];
+    LargeVM<vec3>& xPrev = solverWork[1];
+    LargeVM<vec3>& e = solverWork[2];
+    
+    const GLboolean energy = (solverPolicy.stopping == ENERGY_NORM);
+    
+    e = S * b;
+    GLfloat bb = energy ? dot(e, P_inv * e) : dot(e, e);
+    
+    r = S * (b - (A * x));
+    GLfloat rr = energy ? dot(r, P_inv * r) : dot(r, r);
+    
+    const GLfloat tol2 = solverPolicy.tolerance * solverPolicy.tolerance;
+    const GLsizei budget = solverBudget(A.getRows());
+    GLsizei i = 0;
+    
+    // Warm-up, plain block Jacobi
+    if (jacobiRadius <= 0.0f) {
+        
+        GLfloat eeOld = 0.0f;
+        
+        for (GLsizei k = 0; (k < CHEBYSHEV_WARMUP) && (rr > (tol2 * bb)) && (i < budget); k++) {
+            
+            e = S * (P_inv * r);
+            
+            GLfloat ee = dot(e, e);
+            
+            if (eeOld > 0.0f)
+                jacobiRadius = glm::min(std::sqrt(ee / eeOld), CHEBYSHEV_MAX_RADIUS);
+            
+            eeOld = ee;
+            
+            x = x + e;
+            r = S * (b - (A * x));
+            
+            rr = energy ? dot(r, P_inv * r) : dot(r, r);
+            
+            i++;
+        }
+    }
+    
+    GLfloat omega = 1.0f;
+    
+    xPrev = x;
+    
+    for (GLsizei k = 0; (rr > (tol2 * bb)) && (i < budget); k++) {
+        
+        omega = chebyshevOmega(k, jacobiRadius, omega);
+        
+        // The new iterate overwrites x_k-1 element-wise, then takes the place of x
+        xPrev = (omega * ((x + (S * (P_inv * r))) - xPrev)) + xPrev;
+        std::swap(x, xPrev);
+        
+        r = S * (b - (A * x));
+        
+        i++;
+        
+        if ((((k + 1) % CHEBYSHEV_CHECK) == 0) || (i == budget))
+            rr = energy ? dot(r, P_inv * r) : dot(r, r);
+    }
+    
+    // A solve stopped by its budget measures the radius again
+    if (rr > (tol2 * bb))
+        jacobiRadius = 0.0f;
     
-    // Baraff & Witkin [1998]
+    recordSolve(i, budget, rr, bb);
 }
 
 // TODO: Required Feature, Cloth-Object Collisions
 GLboolean Cloth::sphereCollision(const vec3 center, const GLfloat radius) {
     
+    PROFILE_SCOPE(profiler, PROFILE_SPHERE_COLLISION);
+    
     GLboolean cFlag = GL_FALSE;
     
-    for (auto p = particles.begin(); p != particles.end(); p++) {
+    vec3* position = &particles.position[0];
+    vec3* velocity = &particles.velocity[0];
+    GLboolean* collision = &particles.collision[0];
+    vec3* contactNormal = &particles.contactNormal[0];
+    
+    for (GLsizei i = 0; i < NumP_XY; i++) {
         
-        vec3 delta = p->getPosition() - center; // vector from point to cloth vertices
+        vec3 delta = position[i] - center; // vector from point to cloth vertices
         GLfloat dist = glm::length(delta);
         
         if (dist < radius) { // intersection
             
             cFlag = GL_TRUE;
             
-            p->setCol(GL_TRUE);
-            p->offsetPosition(normalize(delta) * (radius - dist));
+            collision[i] = GL_TRUE;
+            contactNormal[i] = normalize(delta);
+            position[i] += normalize(delta) * (radius - dist);
             
             
-            p->setVelocity(vec3(0));
+            velocity[i] = vec3(0);
         }
     }
     
+    collisionFlag |= cFlag;
+    
     return(cFlag);
 }
 
 GLboolean Cloth::planarCollision(GLfloat plPosY) {
     
+    PROFILE_SCOPE(profiler, PROFILE_PLANAR_COLLISION);
+    
     GLboolean cFlag = GL_FALSE;
     
-    for (auto p = particles.begin(); p != particles.end(); p++) {
+    vec3* position = &particles.position[0];
+    const GLboolean* movable = &particles.movable[0];
+    GLboolean* collision = &particles.collision[0];
+    vec3* contactNormal = &particles.contactNormal[0];
+    
+    for (GLsizei i = 0; i < NumP_XY; i++) {
         
-        if (p->getPosition().y <= plPosY) {
+        if (position[i].y <= plPosY) {
             
             cFlag = GL_TRUE;
             
-            vec3 buffer = p->getPosition();
-            buffer.y = plPosY;
-            
-            p->setPosition(buffer);
+            if (movable[i]) {
+                
+                position[i].y = plPosY;
+                
+                collision[i] = GL_TRUE;
+                contactNormal[i] = vec3(0, 1, 0);
+            }
         }
     }
     
+    collisionFlag |= cFlag;
+    
     return(cFlag);
 }
 
@@ -866,32 +2827,110 @@ GLboolean Cloth::planarCollision(GLfloat plPosY) {
 
 GLvoid Cloth::selfCollision(void) {
     
-    GLboolean flag = GL_TRUE;
+    PROFILE_SCOPE(profiler, PROFILE_SELF_COLLISION);
+    
+    const vec3* position = &particles.position[0];
+    
+    contacts.clear();
+    resets.clear();
     
-    for (auto p = particles.begin(); p != particles.end(); p++) {
+    // Detection only reads positions, each thread gathers its own contacts
+    #pragma omp parallel if (parallelForces())
+    {
+        std::vector<Contact> localContacts;
+        std::vector<GLuint> localResets;
         
-        for (auto f = faces.begin(); f != faces.end(); f++) {
+        #pragma omp for schedule(dynamic, 64) nowait
+        for (GLsizei i = 0; i < NumP_XY; i++) {
             
-            if ((f->particleA->getIndex() != p->getIndex()) &&
-                (f->particleB->getIndex() != p->getIndex()) &&
-                (f->particleC->getIndex() != p->getIndex())) {
+            // Face indices are unsigned, the signed loop index is cast once
+            const GLuint p = (GLuint)i;
+            
+            GLboolean flag = GL_TRUE;
+            
+            for (GLsizei fi = 0; fi < (GLsizei)faces.size(); fi++) {
                 
-                if (pointInTriangle(f->particleA->getPosition(), f->particleB->getPosition(), f->particleC->getPosition(), p->getPosition())) {
+                const Face* f = &faces[fi];
+                
+                if ((f->particleA != p) &&
+                    (f->particleB != p) &&
+                    (f->particleC != p)) {
                     
-                    selfCollisionResponse(*f, *p);
-                    flag = GL_FALSE;
+                    if (pointInTriangle(position[f->particleA], position[f->particleB], position[f->particleC], position[i])) {
+                        
+                        Contact contact = { (GLuint)fi, p };
+                        localContacts.push_back(contact);
+                        flag = GL_FALSE;
+                    }
                 }
             }
+            
+            if (flag && testTriangleIntersect(p))
+                localResets.push_back(p);
         }
         
-        if (flag) {
-            
-            testTriangleIntersect(*p);
+        #pragma omp critical
+        {
+            contacts.insert(contacts.end(), localContacts.begin(), localContacts.end());
+            resets.insert(resets.end(), localResets.begin(), localResets.end());
         }
     }
+    
+    if (contacts.empty() && resets.empty())
+        return;
+    
+    // Restore a deterministic order regardless of which thread found each contact
+    std::sort(contacts.begin(), contacts.end(), [](const Contact& a, const Contact& b) {
+        return((a.particle < b.particle) || ((a.particle == b.particle) && (a.face < b.face)));
+    });
+    
+    // Colour contacts over their four particles, then resolve each batch in parallel
+    GLsizei NumC = (GLsizei)contacts.size();
+    
+    std::vector<GLuint> indices(NumC * 4);
+    
+    for (GLsizei c = 0; c < NumC; c++) {
+        indices[(c * 4) + 0] = contacts[c].particle;
+        indices[(c * 4) + 1] = faces[contacts[c].face].particleA;
+        indices[(c * 4) + 2] = faces[contacts[c].face].particleB;
+        indices[(c * 4) + 3] = faces[contacts[c].face].particleC;
+    }
+    
+    std::vector<GLuint> colours;
+    GLuint numColours = (NumC > 0) ? greedyColouring(&indices[0], 4, NumC, colours) : 0;
+    
+    std::vector<GLsizei> batches(numColours + 1, 0);
+    
+    for (GLsizei c = 0; c < NumC; c++)
+        batches[colours[c] + 1]++;
+    
+    for (GLuint c = 0; c < numColours; c++)
+        batches[c + 1] += batches[c];
+    
+    std::vector<GLsizei> fill(batches.begin(), batches.end() - 1);
+    std::vector<Contact> sorted(NumC);
+    
+    for (GLsizei c = 0; c < NumC; c++)
+        sorted[fill[colours[c]]++] = contacts[c];
+    
+    for (GLuint batch = 0; batch < numColours; batch++) {
+        
+        GLboolean parallel = ((batch < MAX_COLOURS - 1) && ((batches[batch + 1] - batches[batch]) >= PARALLEL_THRESHOLD));
+        
+        #pragma omp parallel for schedule(static) if (parallel)
+        for (GLsizei c = batches[batch]; c < batches[batch + 1]; c++)
+            selfCollisionResponse(faces[sorted[c].face], sorted[c].particle);
+    }
+    
+    // Particles whose path crossed a face are returned to their last position
+    for (auto r = resets.begin(); r != resets.end(); r++) {
+        
+        Particle p(&particles, *r);
+        p.setPosition(p.getLPosition());
+    }
 }
 
-GLboolean Cloth::pointInTriangle(vec3 A, vec3 B, vec3 C, vec3 P) {
+GLboolean Cloth::pointInTriangle(vec3 A, vec3 B, vec3 C, vec3 P) const {
     
     // Prepare barycentric values
     vec3 u = B - A;
@@ -920,12 +2959,14 @@ GLboolean Cloth::pointInTriangle(vec3 A, vec3 B, vec3 C, vec3 P) {
     return(r + t <= 1);
 }
 
-GLboolean Cloth::selfCollisionResponse(Face& face, Particle& mQ) {
+GLboolean Cloth::selfCollisionResponse(Face& face, GLuint q) {
+    
+    vec3* position = &particles.position[0];
     
-    vec3 Q = mQ.getPosition();
-    vec3 pA = face.particleA->getPosition();
-    vec3 pB = face.particleB->getPosition();
-    vec3 pC = face.particleC->getPosition();
+    vec3 Q = position[q];
+    vec3 pA = position[face.particleA];
+    vec3 pB = position[face.particleB];
+    vec3 pC = position[face.particleC];
     
     Q = Q - pA;
     pB = pB - pA;
@@ -947,9 +2988,9 @@ GLboolean Cloth::selfCollisionResponse(Face& face, Particle& mQ) {
     vec3 dcpA = -dcQ - dcpB - dcpC;
     
     GLfloat wQ = 1.0f;
-    GLfloat wA = face.particleA->getMass();
-    GLfloat wB = face.particleB->getMass();
-    GLfloat wC = face.particleC->getMass();
+    GLfloat wA = 1.0f / particles.invMass[face.particleA];
+    GLfloat wB = 1.0f / particles.invMass[face.particleB];
+    GLfloat wC = 1.0f / particles.invMass[face.particleC];
     
     GLfloat denominator = (wA * dot(dcpA, dcpA)) +
                           (wB * dot(dcpB, dcpB)) +
@@ -964,54 +3005,56 @@ GLboolean Cloth::selfCollisionResponse(Face& face, Particle& mQ) {
     vec3 dpB = -wB * S * dcpB;
     vec3 dpC = -wC * S * dcpC;
     
-    mQ.getPosition() += dQ;
-    face.particleA->getPosition() += dpA;
-    face.particleB->getPosition() += dpB;
-    face.particleC->getPosition() += dpC;
+    position[q] += dQ;
+    position[face.particleA] += dpA;
+    position[face.particleB] += dpB;
+    position[face.particleC] += dpC;
     
     return(GL_FALSE);
 }
 
-GLboolean Cloth::testTriangleIntersect(Particle& p) {
- 
-    GLboolean testResult = GL_FALSE;
+// Tests the path of particle i since the last step against the mesh, the caller applies the reset so the test only reads
+GLboolean Cloth::testTriangleIntersect(GLuint i) const {
     
-    for (auto f = faces.begin(); f != faces.end(); f++) {
+    const vec3* position = &particles.position[0];
+    
+    vec3 pos = position[i];
+    vec3 lPos = particles.lastPosition[i];
+    
+    for (GLuint fi = 0; fi < faces.size(); fi++) {
+        
+        const Face* f = &faces[fi];
         
-        if ((f->particleA->getIndex() != p.getIndex()) &&
-            (f->particleB->getIndex() != p.getIndex()) &&
-            (f->particleC->getIndex() != p.getIndex())) {
+        if ((f->particleA != i) &&
+            (f->particleB != i) &&
+            (f->particleC != i)) {
             
-            Face currentFace = *f;
-            vec3 n = normalize(f->normal);
+            vec3 n = normalize(faceNormals[fi]);
             
-            vec3 rayDirection = p.getPosition() - p.getLPosition();
+            vec3 rayDirection = pos - lPos;
             GLfloat nDotD = dot(rayDirection, n);
             
             if ((abs(nDotD) <= 0.100) || (nDotD == 0))
                 return(GL_FALSE);
             else {
                 
-                GLfloat d = dot(n, f->particleA->getPosition());
-                GLfloat t = (d - dot(n, p.getLPosition())) / nDotD;
+                GLfloat d = dot(n, position[f->particleA]);
+                GLfloat t = (d - dot(n, lPos)) / nDotD;
                 
-                intersectQ = p.getLPosition() + (t * rayDirection);
+                vec3 intersectQ = lPos + (t * rayDirection);
                 
-                if ((intersectQ.x >= glm::max(p.getPosition().x, p.getLPosition().x)) ||
-                    (intersectQ.y >= glm::max(p.getPosition().y, p.getLPosition().y)) ||
-                    (intersectQ.z >= glm::max(p.getPosition().z, p.getLPosition().z)) ||
-                    (intersectQ.x <= glm::min(p.getPosition().x, p.getLPosition().x)) ||
-                    (intersectQ.y <= glm::min(p.getPosition().y, p.getLPosition().y)) ||
-                    (intersectQ.z <= glm::min(p.getPosition().z, p.getLPosition().z))) {
+                if ((intersectQ.x >= glm::max(pos.x, lPos.x)) ||
+                    (intersectQ.y >= glm::max(pos.y, lPos.y)) ||
+                    (intersectQ.z >= glm::max(pos.z, lPos.z)) ||
+                    (intersectQ.x <= glm::min(pos.x, lPos.x)) ||
+                    (intersectQ.y <= glm::min(pos.y, lPos.y)) ||
+                    (intersectQ.z <= glm::min(pos.z, lPos.z))) {
                         
                         return(GL_FALSE);
                 }
                 
-                if (pointInTriangle(f->particleA->getPosition(), f->particleB->getPosition(), f->particleC->getPosition(), intersectQ)) {
-                    
-                    p.setPosition(p.getLPosition());
+                if (pointInTriangle(position[f->particleA], position[f->particleB], position[f->particleC], intersectQ))
                     return(GL_TRUE);
-                }
             }
         }
     }
@@ -1021,125 +3064,71 @@ GLboolean Cloth::testTriangleIntersect(Particle& p) {
 // TODO: Required Feature, Basic Wind
 GLvoid Cloth::setWind(const vec3 dir, vec3 rVec) {
     
+    PROFILE_SCOPE(profiler, PROFILE_WIND);
+    
+    vec3* force = &particles.force[0];
+    
     for (auto f = faces.begin(); f != faces.end(); f++) {
         
         vec3 normal = getPolyNormal(f->particleA, f->particleB, f->particleC);
-        vec3 force = normal * dot(normalize(normal), dir + vec3(randFunc(rVec.x),
-                                                                randFunc(rVec.y),
-                                                                randFunc(rVec.z)));
+        vec3 wForce = normal * dot(normalize(normal), dir + vec3(randFunc(rVec.x),
+                                                                 randFunc(rVec.y),
+                                                                 randFunc(rVec.z)));
         
-        f->particleA->addForce(force);
-        f->particleB->addForce(force);
-        f->particleC->addForce(force);
+        force[f->particleA] += wForce;
+        force[f->particleB] += wForce;
+        force[f->particleC] += wForce;
     }
 }
 
-GLuint Cloth::loadTexture(const char* path) {
-    
-    /*
-    GLint width, height;
-    
-    glGenTextures(1, &TextureID);
-    unsigned char* image = SOIL_load_image(path, &width, &height, 0, SOIL_LOAD_RGB);
+GLvoid Cloth::updateFaceNormals(void) {
     
-    // Assign Texture to ID
-    glBindTexture(GL_TEXTURE_2D, TextureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    faceNormals.resize(faces.size());
     
-    // Parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    
-    glBindTexture(GL_TEXTURE_2D, 0);
-    SOIL_free_image_data(image);
-    
-    return(TextureID);
-    */
-    
-    return(0);
+    for (GLsizei fi = 0; fi < (GLsizei)faces.size(); fi++)
+        faceNormals[fi] = normalize(getPolyNormal(faces[fi].particleA, faces[fi].particleB, faces[fi].particleC));
 }
 
-GLvoid Cloth::render(const Shader* shader) {
+// Vertex normals, the sum of the unit normals of the faces sharing each particle
+GLvoid Cloth::updateVertexNormals(void) {
     
-    glPolygonMode(GL_FRONT_AND_BACK, (drawWire ? GL_LINE : GL_FILL));
+    PROFILE_SCOPE(profiler, PROFILE_NORMALS);
     
-    GLuint texture;
+    vec3* normal = &particles.normal[0];
     
-    for (auto p = particles.begin(); p != particles.end(); p++)
-        p->resetNormal();
+    for (GLsizei i = 0; i < NumP_XY; i++)
+        normal[i] = vec3(0);
     
-    // Vertex Normals
     for (auto f = faces.begin(); f != faces.end(); f++) {
         
-        vec3 newNormal = getPolyNormal(f->particleA, f->particleB, f->particleC);
+        vec3 newNormal = normalize(getPolyNormal(f->particleA, f->particleB, f->particleC));
         
-        f->particleA->addToNormal(newNormal);
-        f->particleB->addToNormal(newNormal);
-        f->particleC->addToNormal(newNormal);
-    }
-    
-    glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
-    
-    glGenBuffers(1, &VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    
-    GLuint positionAttributeLocation = glGetAttribLocation(shader->ProgramID, "i_position");
-    glEnableVertexAttribArray(positionAttributeLocation);
-    glVertexAttribPointer(positionAttributeLocation, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid *)0);
-    
-    // TODO: Extended Feature, Blinn-Phong Lighting
-    
-    GLuint normalAttributeLocation = glGetAttribLocation(shader->ProgramID , "i_normal");
-    glEnableVertexAttribArray(normalAttributeLocation);
-    glVertexAttribPointer(normalAttributeLocation, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid *)sizeof(vec3));
-    
-    GLuint uvAttributeLocation = glGetAttribLocation(shader->ProgramID, "i_uv");
-    glEnableVertexAttribArray(uvAttributeLocation);
-    glVertexAttribPointer(uvAttributeLocation, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid *)(sizeof(vec3) + sizeof(vec3)));
-    
-    // TODO: Extended Feature, Texturing
-    
-    glGenBuffers(1, &EBO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, vertexIndices.size() * sizeof(GLuint), &vertexIndices[0], GL_STATIC_DRAW);
-    
-    //texture = loadTexture(TEX_PATH);
-    
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glUniform1i(glGetUniformLocation(shader->ProgramID, "i_texture"), 0);
-    
-    vector<Vertex> vertexData;
-    
-    for (GLsizei j = 0; j <= NumPY; j++) {
-        for (GLsizei i = 0; i <= NumPX; i++) {
-            
-            Vertex v;
-            v.position = getParticle(i, j)->getPosition();
-            v.normal = getParticle(i, j)->getNormal();
-            v.uv = vec2((i / NumPX), (j / NumPY));
-            vertexData.push_back(v);
-        }
+        normal[f->particleA] += newNormal;
+        normal[f->particleB] += newNormal;
+        normal[f->particleC] += newNormal;
     }
-    
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(Vertex), value_ptr(vertexData[0].position), GL_STATIC_DRAW);
-    
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, (GLsizei)vertexIndices.size(), GL_UNSIGNED_INT, 0);
+}
 
-    // Deallocate Memory
-    glDeleteTextures(1, &texture);
-    
-    glDisableVertexAttribArray(positionAttributeLocation);
-    glDisableVertexAttribArray(normalAttributeLocation);
-    glDisableVertexAttribArray(uvAttributeLocation);
-    
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);    
-}
\ No newline at end of file
+ProfileStats Cloth::getProfileStats(ProfilePhase phase) const {
+    return(profiler.getStats(phase));
+}
+
+Profiler& Cloth::getProfiler(void) {
+    return(profiler);
+}
+
+const std::vector<GLuint>& Cloth::getVertexIndices(void) const {
+    return(vertexIndices);
+}
+
+const std::vector<GLuint>& Cloth::getParticleGrid(void) const {
+    return(particleToGrid);
+}
+
+GLuint Cloth::getNumPX(void) const {
+    return(NumPX);
+}
+
+GLuint Cloth::getNumPY(void) const {
+    return(NumPY);
+}
@@ -4,29 +4,36 @@
 
 #pragma once
 
-// OpenGL Extensions Wrangler Library
-#include <GL/glew.h>
+// OpenGL Scalar Types, see GLTypes.hpp
+#include "GLTypes.hpp"
 
 // OpenGL Mathematics Library
 #include <GLM/glm.hpp>
 #include <GLM/gtc/matrix_transform.hpp>
-#include <GLM/gtc/type_ptr.hpp>
-
-// Simple OpenGL Image Loading Library
-//#include <SOIL.h>
 
 // OpenMP Multi-Processing Library
+#ifdef _OPENMP
 #include <omp.h>
+#endif
 
 // C/C++ Standard Libraries
+#include <algorithm>
+#include <cfloat>
 #include <cmath>
+#include <functional>
+#include <queue>
 #include <vector>
 
 // Internal Dependancies
+#include "ParticleStore.hpp"
+#include "SpringKernel.hpp"
+#include "ConstraintStore.hpp"
+#include "Profiler.hpp"
 #include "Particle.hpp"
 #include "LargeVM.hpp"
-#include "Shader.hpp"
-
+#include "BlockSparseMatrix.hpp"
+#include "Multigrid.hpp"
+#include "SparseLDLT.hpp"
 
 #define GD -0.400f
 #define KSST 10.00f
@@ -36,7 +43,25 @@
 #define KDSH -0.200f
 #define KDBE -0.400f
 
-#define TEX_PATH "4K_UJ_FLAG.png"
+#define STRUCTURAL_SPRING 0
+#define SHEAR_SPRING 1
+#define BEND_SPRING 2
+#define SPRING_TYPES 3
+
+#define PARALLEL_THRESHOLD 4096 // Minimum particle count before force passes are split across threads
+#define FUSED_TILE 256 // Particles integrated per tile of the serial fused step
+#define TILE_SIZE 8 // Tiled particle ordering, tile edge in particles
+#define MAX_COLOURS 64 // Greedy colouring limit, one bit per colour in the per particle masks
+#define SOLVER_HISTORY 8 // Recent implicit solves the adaptive iteration budget is taken over
+#define PROJECTIVE_ITERATIONS 10 // Local/global iterations per Projective Dynamics step
+#define DISSECTION_LEAF 64 // Nested dissection stops splitting grid blocks of this many points
+#define CHEBYSHEV_WARMUP 8 // Plain Jacobi iterations the spectral radius is estimated over
+#define CHEBYSHEV_CHECK 4 // Chebyshev iterations between convergence checks, the only reductions of the iteration
+#define CHEBYSHEV_MAX_RADIUS 0.999f // Spectral radius estimates are clamped below 1
+#define CHEBYSHEV_RELAXATION 0.9f // Under-relaxation of the position based Jacobi iterations, Wang [2015]
+#define XPBD_MAX_SUBSTEP 0.05f // Longest XPBD substep, a step takes ceil(dt / XPBD_MAX_SUBSTEP) substeps of one sweep each
+#define STEP_GROWTH 2.0f // Adaptive stepping, largest growth of the explicit step from one step to the next
+#define STEP_SHRINK 0.2f // Adaptive stepping, largest reduction of the explicit step after a step
 
 class Cloth {
     
@@ -45,7 +70,7 @@ public:
     enum ParticleModel {
         
         FORCE_MODEL,        // MS Model
-        POSITION_MODEL      // PBD Model
+        POSITION_MODEL      // PBD Model, integrated by XPBD
     };
     
     enum IntegrationMethod {
@@ -58,43 +83,115 @@ public:
         RK2_EULER,
         RK4_EULER,
         VERLET,
+        PROJECTIVE,
+        XPBD,
+        MULTIRATE,
         DEFAULT
     };
     
+    enum ForceAccumulation {
+        
+        SERIAL_SCATTER,     // Single threaded, forces scattered onto both particles of each spring
+        THREAD_BUFFERS,     // Per thread force buffers, reduced per particle
+        GATHER              // Per spring forces, summed by each particle over the springs it owns
+    };
+    
+    // Particle storage order over the grid, neighbours in y fall a whole row apart in ROW_MAJOR
+    enum ParticleOrdering {
+        
+        ROW_MAJOR,
+        TILED,              // TILE_SIZE x TILE_SIZE tiles in row-major order, row-major within each tile
+        MORTON              // Z-order curve over the grid coordinates
+    };
+    
     enum Preset {
         
         One,
         Two
     };
     
-    struct Vertex {
+    // Implicit solve stopping criteria, both relative to the filtered right hand side S b
+    enum SolverStopping {
         
-        glm::vec3 position;
-        glm::vec3 normal;
-        glm::vec2 uv;
+        RELATIVE_RESIDUAL,  // |r| <= tolerance |S b|
+        ENERGY_NORM         // Error in the A norm, |e|_A^2 = r^T A^-1 r, estimated with the preconditioner as r^T P^-1 r
     };
     
-    struct Spring {
+    // Implicit linear solvers
+    enum SolverBackend {
         
-        Particle* particleA;
-        Particle* particleB;
+        PCCG,               // Modified Pre-Conditioned Conjugate Gradient, Baraff & Witkin [1998]
+        MULTIGRID_V,        // Geometric multigrid over the particle lattice, one V-cycle per iteration
+        MULTIGRID_W,        // Geometric multigrid, one W-cycle per iteration
+        CHEBYSHEV_JACOBI    // Block Jacobi with Chebyshev semi-iterative acceleration, Wang [2015]
+    };
+    
+    // Position based constraint iterations, see constraintsInverse
+    enum ConstraintSolver {
         
-        GLfloat Ks, Kd;     // Mass-Spring vars, Stiffness & Damping constants
-        GLfloat K, Kp;      // Position Dynamic vars, ...
+        COLOURED_GAUSS_SEIDEL,  // One pass over the constraint batches
+        ACCELERATED_JACOBI,     // solverIterations Chebyshev accelerated Jacobi iterations, no batches
+        LONG_RANGE_ATTACHMENTS  // One pass of tethers to the pinned particles, Kim et al. [2012], then the coloured pass
+    };
+    
+    // Implicit solver settings, see setSolverPolicy
+    struct SolverPolicy {
         
-        GLfloat restLength;
+        SolverBackend backend;
+        SolverStopping stopping;
+        GLfloat tolerance;
+        GLboolean warmStart;        // Start from the previous step's velocity change
+        GLboolean adaptiveBudget;   // Cap the iterations from the recent convergence history
+        GLsizei maxIterations;      // Hard cap, 0 for three times the system rows
+    };
+    
+    // Convergence of the last implicit solve
+    struct SolverStats {
+        
+        GLsizei iterations;
+        GLsizei budget;             // Iteration cap the solve ran under
+        GLfloat residual;           // Relative residual on exit, in the stopping norm
+        GLboolean converged;
+    };
+    
+    // Adaptive time stepping settings, see setStepPolicy
+    struct StepPolicy {
+        
+        GLboolean adaptive;         // Split each frame into steps sized by an error estimate or stability bound
+        GLfloat tolerance;          // Explicit schemes, local position error allowed per step
+        GLfloat safety;             // Symplectic schemes, fraction of the stability bound taken
+        GLfloat minStep, maxStep;
+        GLsizei maxSteps;           // Frame budget, frame time past it is dropped
+    };
+    
+    // Steps of the last frame
+    struct StepStats {
         
-        GLuint type;
+        GLsizei steps;              // Accepted steps
+        GLsizei rejected;           // Explicit schemes, trial steps rejected by the error estimate
+        GLfloat step;               // Length of the last accepted step
+        GLfloat time;               // Time advanced, short of the frame time when the budget ran out
+        GLfloat error;              // Explicit schemes, error estimate of the last step relative to the tolerance
+        GLboolean limited;          // The budget ran out, or the minimum step was taken past the tolerance
+        GLsizei solves;             // Implicit schemes, solves over all the frame's steps, see recordSolve
+        GLsizei iterations;         // Summed over the solves
+        GLsizei maxIterations;
+        GLfloat residual;           // Summed over the solves
+        GLsizei unconverged;
     };
     
     struct Face {
         
-        Particle* particleA;
-        Particle* particleB;
-        Particle* particleC;
+        GLuint particleA;
+        GLuint particleB;
+        GLuint particleC;
+    };
+    
+    // Self collision contact, particle against a face it lies within
+    struct Contact {
         
-        glm::vec3 centrePos;
-        glm::vec3 normal;
+        GLuint face;
+        GLuint particle;
     };
     
     struct Simplex {
@@ -110,21 +207,24 @@ public:
     // Initialisations
     GLvoid initMesh(GLfloat uWidth, GLfloat uHeight, GLuint nPX, GLuint nPY, Preset preset);
     GLvoid initExtentions(void);
-    GLuint loadTexture(const char* path);
     
     GLvoid generateSprings(GLuint x, GLuint y);
     
-    GLvoid initSpring(Particle* pA, Particle* pB, GLfloat ks, GLfloat kd, GLuint id);
-    GLvoid initFace(Particle* pA, Particle* pB, Particle* pC);
+    GLvoid initSpring(GLuint pA, GLuint pB, GLuint id, GLuint colour);
+    GLvoid initFace(GLuint pA, GLuint pB, GLuint pC);
     
     GLvoid setFixedParticle(GLuint x, GLuint y);
     
+    GLvoid reorderParticles(const std::vector<GLuint>& remap);
+    
     GLvoid generateElementIndices(GLuint x, GLuint y, GLuint* e);
     
-    inline Particle* getParticle(GLuint x, GLuint y);
+    inline Particle getParticle(GLuint x, GLuint y);
     inline GLuint getParticleIndex(GLuint x, GLuint y);
-    inline glm::vec3 getPolyNormal(Particle* pA, Particle* pB, Particle* pC);
-    inline glm::vec3 verletVelocity(Particle& p, GLfloat dt);
+    inline glm::vec3 getPolyNormal(GLuint pA, GLuint pB, GLuint pC);
+    inline glm::vec3 verletVelocity(GLuint i, GLfloat dt);
+    inline GLvoid setNewPosition(GLuint i, const glm::vec3& X);
+    inline GLvoid setNewVelocity(GLuint i, const glm::vec3& V);
     inline GLfloat randFunc(GLfloat variation);
     
     GLvoid updateFaceNormals(void);
@@ -132,13 +232,19 @@ public:
     // Internal Properties
     GLvoid setStiffness(GLfloat stS, GLfloat shS, GLfloat beS);
     GLvoid setDamping(GLfloat stD, GLfloat shD, GLfloat beD, GLfloat gD);
+    GLvoid setSpringRates(GLuint stR, GLuint shR, GLuint beR);
+    
+    // Memory Layout
+    GLvoid setParticleOrdering(ParticleOrdering order);
+    ParticleOrdering getParticleOrdering(void) const;
     
-    GLvoid setWire(GLboolean flag);
+    const ParticleStore& getParticles(void) const;
+    const std::vector<Spring>& getConstraints(void) const;
     
     // External Forces
     GLvoid addForce(const glm::vec3 direction);
     GLvoid setWind(const glm::vec3 dir, glm::vec3 rVec);
-    GLvoid addWindForcesForTriangle(Particle* pA, Particle* pB, Particle* pC);
+    GLvoid addWindForcesForTriangle(GLuint pA, GLuint pB, GLuint pC);
     
     // Cloth-ObjectMesh Collisions
     GLboolean sphereCollision(const glm::vec3 center, const GLfloat radius);
@@ -146,14 +252,34 @@ public:
     
     // Cloth-Cloth Collisions
     GLvoid selfCollision(void);
-    GLboolean pointInTriangle(glm::vec3 A, glm::vec3 B, glm::vec3 C, glm::vec3 P);
-    GLboolean selfCollisionResponse(Face& face, Particle& mQ);
-    GLboolean testTriangleIntersect(Particle& particle);
+    GLboolean pointInTriangle(glm::vec3 A, glm::vec3 B, glm::vec3 C, glm::vec3 P) const;
+    GLboolean selfCollisionResponse(Face& face, GLuint q);
+    GLboolean testTriangleIntersect(GLuint p) const;
     
     // Physics
     GLvoid stepSimulation(GLfloat dt, IntegrationMethod method, GLboolean dynamicInverse);
+    GLsizei advanceFrame(GLfloat frameTime, IntegrationMethod method, GLboolean dynamicInverse);
+    GLvoid fusedStep(GLfloat dt, IntegrationMethod method);
     GLvoid computeForces(GLfloat dt, IntegrationMethod method);
+    inline glm::vec3 evaluateSpring(GLsizei s, IntegrationMethod method);
+    
+    GLvoid evaluateSprings(IntegrationMethod method);
+    
+    GLvoid setForceAccumulation(ForceAccumulation mode);
+    GLvoid setSpringKernel(SpringKernel::ISA isa);
+    GLvoid setFusedStep(GLboolean fuse);
+    inline GLboolean parallelForces(void);
+    GLvoid buildAdjacency(void);
+    
+    // Constraint Colouring, batches of constraints sharing no particle
+    GLuint greedyColouring(const GLuint* indices, GLuint arity, GLsizei count, std::vector<GLuint>& colours);
+    GLvoid buildConstraintBatches(void);
+    inline GLboolean parallelBatch(GLsizei batch);
     GLvoid constraintsInverse(IntegrationMethod m); // Provot [1995], 'Deformation Constraints in a Mass-Spring Model to Describe Rigid Cloth Behavior'
+    GLvoid constraintsJacobi(IntegrationMethod m);
+    GLvoid constraintsTethers(IntegrationMethod m); // Kim et al. [2012], 'Long Range Attachments - A Method to Simulate Inextensible Clothing in Computer Games'
+    GLvoid buildTethers(void);
+    GLvoid setConstraintSolver(ConstraintSolver solver);
     
     /// NUMERICAL INTEGRATION SCHEMES - EXPlicit, SYMplectic, IMPlicit
     
@@ -161,40 +287,117 @@ public:
     GLvoid EXP_ForwardEuler(GLfloat dt);
     GLvoid IMP_BackwardEuler(GLfloat dt); // Standard Backward Euler
     GLvoid IMP_ModifiedBackwardEuler(GLfloat dt); // Baraff & Witkin [1998], 'Large steps in cloth simulation'
+    GLvoid IMP_ProjectiveDynamics(GLfloat dt); // Bouaziz et al. [2014], 'Projective Dynamics: Fusing Constraint Projections for Fast Simulation'
     GLvoid SYM_ForwardBackwardEuler(GLfloat dt);
     GLvoid SYM_ModifiedForwardBackwardEuler(GLfloat dt); // Desbrun et al. [1999], 'Interactive animation of structured deformable objects', AKA IMEX
+    GLvoid SYM_MultiRateEuler(GLfloat dt); // Symplectic Euler, each spring type on its own number of substeps
     
     // Higher-Order Integration Methods
     GLvoid EXP_Verlet(GLfloat dt);
     GLvoid EXP_RungeKutta2(GLfloat dt);
     GLvoid EXP_RungeKutta4(GLfloat dt);
     
-    // Supporting Integration Functions
-    GLvoid RK_Stepper(Particle& p, GLfloat dTS, GLfloat fac);
-    GLvoid SolveGD(LargeVM<glm::mat3> A, LargeVM<glm::vec3>& x, LargeVM<glm::vec3> b); // Gradient Descent Method
-    GLvoid SolveCG(LargeVM<glm::mat3> A, LargeVM<glm::vec3>& x, LargeVM<glm::vec3> b); // Conjugate Gradient Method
-    GLvoid SolvePCCG(LargeVM<glm::mat3> A, LargeVM<glm::vec3>& x, LargeVM<glm::vec3> b, LargeVM<glm::vec3> P, LargeVM<glm::vec3> P_inv); // Pre-Conditioned Conjugate Gradient Method
+    // Position Based Methods
+    GLvoid PBD_ExtendedPositionBased(GLfloat dt); // Macklin et al. [2016], 'XPBD: Position-Based Simulation of Compliant Constrained Dynamics'
     
-    // Draw Vertex/Position Array
-    GLvoid render(const Shader* shader);
+    // Supporting Integration Functions
+    inline GLvoid integrateParticle(GLuint i, GLfloat dt, IntegrationMethod method);
+    GLvoid assembleSystem(GLfloat dt, IntegrationMethod method);
+    GLvoid prepareSolve(void);
+    GLvoid setSolverPolicy(const SolverPolicy& policy);
+    const SolverPolicy& getSolverPolicy(void) const;
+    const SolverStats& getSolverStats(void) const;
+    GLsizei solverBudget(GLsizei rows) const;
+    GLvoid recordSolve(GLsizei iterations, GLsizei budget, GLfloat rr, GLfloat bb);
+    GLvoid SolveGD(const BlockSparseMatrix& A, LargeVM<glm::vec3>& x, const LargeVM<glm::vec3>& b); // Gradient Descent Method
+    GLvoid SolveCG(const BlockSparseMatrix& A, LargeVM<glm::vec3>& x, const LargeVM<glm::vec3>& b); // Conjugate Gradient Method
+    GLvoid SolvePCCG(const BlockSparseMatrix& A, LargeVM<glm::vec3>& x, const LargeVM<glm::vec3>& b, const LargeVM<glm::mat3>& S, const LargeVM<glm::mat3>& P_inv); // Modified Pre-Conditioned Conjugate Gradient Method, Baraff & Witkin [1998]
+    GLvoid SolveMultigrid(const BlockSparseMatrix& A, LargeVM<glm::vec3>& x, const LargeVM<glm::vec3>& b, const LargeVM<glm::mat3>& S, const LargeVM<glm::mat3>& P_inv); // Geometric Multigrid Method, see Multigrid.hpp
+    GLvoid SolveChebyshev(const BlockSparseMatrix& A, LargeVM<glm::vec3>& x, const LargeVM<glm::vec3>& b, const LargeVM<glm::mat3>& S, const LargeVM<glm::mat3>& P_inv); // Chebyshev Semi-Iterative Block Jacobi Method, Wang [2015]
+    GLvoid solveSystem(LargeVM<glm::vec3>& x, const LargeVM<glm::vec3>& b);
+    GLvoid factorProjective(GLfloat dt);
+    GLvoid buildIMEXFilters(GLfloat dt);
+    GLvoid buildPositionConstraints(void);
+    GLvoid buildSpringGroups(void);
+    
+    // Adaptive Time Stepping
+    GLvoid setStepPolicy(const StepPolicy& policy);
+    const StepPolicy& getStepPolicy(void) const;
+    const StepStats& getStepStats(void) const;
+    GLfloat stabilityStep(IntegrationMethod method);
+    GLfloat doubledStep(GLfloat dt, IntegrationMethod method, GLboolean dynamicInverse);
+    GLvoid restoreStepState(void);
+    
+    // Render Data, consumed by ClothRenderer
+    GLvoid updateVertexNormals(void);
+    
+    const std::vector<GLuint>& getVertexIndices(void) const;
+    const std::vector<GLuint>& getParticleGrid(void) const;
+    GLuint getNumPX(void) const;
+    GLuint getNumPY(void) const;
+    
+    // Phase Timings, recorded when built with CLOTH_PROFILING
+    // A frame closes at the end of each stepSimulation, so a render lands in the frame of the following step
+    ProfileStats getProfileStats(ProfilePhase phase) const;
+    Profiler& getProfiler(void);
     
 private:
     
     int tmp;
     
     std::vector<Face> faces;
+    std::vector<glm::vec3> faceNormals;  // Rest state face normals, used by the ray-triangle self collision test
+    
+    // Grid To Storage Order Mapping
+    ParticleOrdering ordering;
+    
+    std::vector<GLuint> gridToParticle;  // Particle index of grid point x + y * (NumPX + 1)
+    std::vector<GLuint> particleToGrid;  // Grid point of each particle, used for rendering
     
     std::vector<Spring> constraints;     // Standard Mass-Spring/Particle-System constraints
-    std::vector<Spring> dConstraints;    // Standard Position Based Dynamics distance constraints
+    ConstraintStore dConstraints;        // Position Based Dynamics distance & bending constraints, built on the first XPBD step
+    
+    std::vector<SpringMaterial> materials; // Spring material table, indexed by Spring::material
+    
+    // Parallel Force Accumulation
+    ForceAccumulation accumulation;
+    GLboolean fuseStep;                    // Single pass force, integration & reset for F_EULER, FB_EULER & VERLET
+    
+    std::vector<GLuint> adjacencyOffsets;  // Per particle offsets into adjacency
+    std::vector<GLuint> adjacency;         // Per particle spring lists, (spring << 1) | side
+    
+    SpringKernel springKernel;             // Vectorised spring force evaluation, see SpringKernel.hpp
+    
+    AlignedVector<glm::vec3> springForce;  // Per spring resultant force on its first particle
+    AlignedVector<glm::vec3> threadForces; // Per thread force buffers, thread buffered accumulation
     
-    std::vector<Particle> particles;
+    // Constraint Batches, no two constraints of a batch share a particle
+    std::vector<GLsizei> constraintBatches; // Per colour offsets into batchSprings
+    std::vector<GLuint> batchSprings;       // Spring indices grouped by colour
+    
+    // Accelerated Jacobi Constraint Iterations
+    ConstraintSolver constraintSolver;
+    GLfloat constraintRadius;               // Spectral radius estimate, 0 until the warm-up has measured one
+    std::vector<glm::vec3> jacobiPositions; // Current & previous iterates
+    std::vector<glm::vec3> jacobiPrevious;
+    std::vector<glm::vec3> springCorrection; // Per spring correction of the first particle, the second takes its negation
+    std::vector<GLuint> springColours;      // Build time lattice colours, recorded by generateSprings
+    
+    // Long Range Attachments, one tether per free particle to its geodesically nearest pinned particle
+    std::vector<GLint> tetherAnchor;        // Per particle anchor, -1 when no pinned particle is reachable
+    std::vector<GLfloat> tetherLength;      // Per particle geodesic rest distance to the anchor
+    std::vector<GLboolean> tetherMovable;   // Pin flags the tethers were built for
+    
+    std::vector<Contact> contacts;          // Self collision contacts, gathered each step
+    std::vector<GLuint> resets;             // Self collision path crossings, gathered each step
+    
+    Profiler profiler;                      // Per phase timings, see Profiler.hpp
+    
+    ParticleStore particles;             // Structure-of-arrays particle streams, see ParticleStore.hpp
     std::vector<GLuint> vertexIndices;
     
-    GLboolean drawWire;
     GLboolean collisionFlag;
     
-    glm::vec3 intersectQ;
-    
     // Number of Particles X,Y & Total Particles
     const GLuint NumPX, NumPY;
     const GLsizei NumP_XY;
@@ -202,41 +405,84 @@ private:
     // Preset No.
     const Preset pset;
     
-    // Dampening & Stiffness Constants
+    // Dampening Constant, spring stiffness & damping constants are held by the material table
     GLfloat GlobalDamping;
-    GLfloat KsStruct,   KdStruct;
-    GLfloat KsShear,    KdShear;
-    GLfloat KsBend,     KdBend;
     
     // Physical Constants
     const glm::vec3 Gravity;
     
     // Integration Objects
-    std::vector<glm::vec3> sForce;        // Explicit Runge-Kutta 4, Sum of Forces
-    std::vector<glm::vec3> sVelocity;     // Explicit Runge-Kutta 4, Sum of Velocities
+    std::vector<glm::vec3> rkExternal;    // Explicit Runge-Kutta, external forces applied before the step, the base of every stage's forces
+    std::vector<glm::vec3> rkPosition;    // Explicit Runge-Kutta, state at the start of the step
+    std::vector<glm::vec3> rkVelocity;
+    std::vector<glm::vec3> rkSumX;        // Explicit Runge-Kutta 4, weighted sum of the stage velocities
+    std::vector<glm::vec3> rkSumV;        // Explicit Runge-Kutta 4, weighted sum of the stage accelerations
+    
+    std::vector<glm::vec3> pForce;        // Symplectic IMEX, Predicted Force, kept between steps
+    GLfloat imexDt;                       // Symplectic IMEX, time step of the cached filters
+    std::vector<GLfloat> imexInvMass;     // Symplectic IMEX, inverse masses of the cached filters
+    std::vector<glm::mat3> imexFilter;    // Symplectic IMEX, filter of each distinct mass
+    std::vector<GLuint> imexClass;        // Symplectic IMEX, per particle index into imexFilter
+    
+    LargeVM<glm::mat3> mMat;         // Implicit Backward Euler, System Mass Matrix, per particle diagonal blocks
+    LargeVM<glm::mat3> kMat;         // Implicit Euler Schemes, per spring stiffness Jacobian ∂F/∂X, sized on first use
+    BlockSparseMatrix systemMatrix;  // Implicit Euler Schemes, M - dt^2 K (Modified, M - dt D - dt^2 K), pattern built on first use
+    LargeVM<glm::mat3> sMat;         // Implicit Euler Schemes, per particle constraint filter, sized on first use
+    LargeVM<glm::mat3> pMat;         // Implicit Euler Schemes, block Jacobi preconditioner, inverse diagonal blocks of systemMatrix
+    LargeVM<glm::vec3> rhs;          // Implicit Euler Schemes, right hand side of the system
+    LargeVM<glm::vec3> X, V, F, Vnew;
     
-    std::vector<glm::vec3> pForce;        // Symplectic IMEX, Predicted Force
+    LargeVM<glm::mat3> dMat;         // Implicit Modified Backward Euler, per spring damping Jacobian ∂F/∂V, sized on first use
+    LargeVM<glm::vec3> dV;           // Implicit Euler Schemes, velocity change ΔV of the last step, the warm start of the next
+    
+    SolverPolicy solverPolicy;
+    SolverStats solverStats;
+    GLsizei solverHistory[SOLVER_HISTORY];  // Iterations of the recent solves
+    GLsizei solverHistoryCount, solverHistoryNext;
+    LargeVM<glm::vec3> solverWork[4];       // CG/PCCG residual, direction, product & preconditioned residual, kept between solves
+    Multigrid multigrid;                    // Multigrid levels, built on the first multigrid solve
+    GLfloat jacobiRadius;                   // Chebyshev backend, spectral radius estimate of block Jacobi, 0 until measured
+    GLfloat jacobiRadiusDt;                 // Time step of the estimate
+    
+    SparseLDLT projectiveSystem;                // Projective Dynamics, factor of M / dt^2 + L, L the spring weighted Laplacian
+    GLfloat projectiveDt;                       // Time step of the factor
+    GLboolean projectiveStale;                  // Stiffness changed since the factor
+    std::vector<GLboolean> projectiveMovable;   // Pin flags of the factor, pinned particles are eliminated
+    std::vector<glm::vec3> projectiveInertia;   // Projective Dynamics, inertial positions x + dt v + dt^2 M^-1 F_ext
+    std::vector<glm::vec3> projectivePositions; // Projective Dynamics, global step iterate, also its right hand side
+    std::vector<glm::vec3> springProjection;    // Projective Dynamics, per spring local step, rest length along the spring
+    
+    std::vector<glm::vec3> xpbdPrevious;        // XPBD, positions at the start of the substep
+    
+    // Multi-rate symplectic Euler, the springs of one type & their forces, held between evaluations
+    struct SpringGroup {
+        
+        std::vector<Spring> springs;            // In first particle order, as constraints
+        std::vector<GLuint> adjacencyOffsets;   // Per particle offsets into adjacency
+        std::vector<GLuint> adjacency;          // Per particle spring lists, (spring << 1) | side
+        AlignedVector<glm::vec3> springForce;   // Per spring resultant force on its first particle
+        std::vector<glm::vec3> force;           // Per particle sum of the group's spring forces, held between evaluations
+    };
     
-    LargeVM<glm::mat3> mMat;         // Implicit Backward Euler, System Mass Matrix
-    LargeVM<glm::mat3> kMat;     // Implicit Backward Euler, Jacobian System Stiffness Matrix
-    LargeVM<glm::vec3> X, V, F, Vnew;
+    GLuint springRates[SPRING_TYPES];           // Multi-rate, evaluations per step of each spring type
+    std::vector<SpringGroup> springGroups;      // Multi-rate, one group per spring type, built on the first step
     
-    std::vector<glm::mat3> dForceDX;      // Implicit Modified Backward Euler, ∂F/∂X, Partial Differential (ΔForces / ΔPositions)
-    std::vector<glm::mat3> dForceDV;      // Implicit Modified Backward Euler, ∂F/∂V, Partial Differential (ΔForces / ΔVelocitys)
+    StepPolicy stepPolicy;
+    StepStats stepStats;
+    GLfloat stepProposal;                       // Explicit schemes, next step length from the error controller, 0 until known
+    std::vector<glm::vec3> stepExternal;        // External forces applied before the frame, restored before every step
+    std::vector<glm::vec3> stepPosition;        // Step doubling, state before the trial step
+    std::vector<glm::vec3> stepVelocity;
+    std::vector<glm::vec3> stepLastPosition;
+    std::vector<glm::vec3> stepLastVelocity;
+    std::vector<glm::vec3> stepTrial;           // Step doubling, positions after the single full step
     
-    const GLfloat EPS;          // Implicit CG/PCCG constant
+    const GLfloat EPS;          // Implicit CG/PCCG constant, relative residual tolerance
     const GLsizei IMAX;         // Implicit CG/PCCG constant
     
     
     const GLsizei solverIterations; // No. of Iterations of constraints satisfaction PBD
     
-    // GL Objects
-    GLuint TextureID;
-    
-    GLuint VAO;
-    GLuint VBO;
-    GLuint EBO;
-    
 };
 
 #endif /* Cloth_hpp */
@@ -0,0 +1,156 @@
+#include "ClothRenderer.hpp"
+
+using namespace std;
+using namespace glm;
+
+ClothRenderer::ClothRenderer(void)
+{
+
+    indexedCloth = NULL;
+    indexCount = 0;
+
+    drawWire = GL_FALSE;
+
+    TextureID = NULL;
+
+    VAO = NULL;
+    VBO = NULL;
+    EBO = NULL;
+}
+
+ClothRenderer::~ClothRenderer(void)
+{
+
+    if (VAO) {
+
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+    }
+}
+
+GLuint ClothRenderer::loadTexture(const char* path) {
+
+    /*
+    GLint width, height;
+
+    glGenTextures(1, &TextureID);
+    unsigned char* image = SOIL_load_image(path, &width, &height, 0, SOIL_LOAD_RGB);
+
+    // Assign Texture to ID
+    glBindTexture(GL_TEXTURE_2D, TextureID);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    // Parameters
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    SOIL_free_image_data(image);
+
+    return(TextureID);
+    */
+
+    return(0);
+}
+
+GLvoid ClothRenderer::setWire(GLboolean flag) {
+    drawWire = flag;
+}
+
+GLvoid ClothRenderer::render(Cloth* cloth, const Shader* shader) {
+
+    glPolygonMode(GL_FRONT_AND_BACK, (drawWire ? GL_LINE : GL_FILL));
+
+    GLuint texture;
+
+    cloth->updateVertexNormals();
+
+    // Buffers persist between frames, only the vertex data is streamed each frame
+    if (!VAO) {
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+    }
+
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+    GLuint positionAttributeLocation = glGetAttribLocation(shader->ProgramID, "i_position");
+    glEnableVertexAttribArray(positionAttributeLocation);
+    glVertexAttribPointer(positionAttributeLocation, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid *)0);
+
+    // TODO: Extended Feature, Blinn-Phong Lighting
+
+    GLuint normalAttributeLocation = glGetAttribLocation(shader->ProgramID , "i_normal");
+    glEnableVertexAttribArray(normalAttributeLocation);
+    glVertexAttribPointer(normalAttributeLocation, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid *)sizeof(vec3));
+
+    GLuint uvAttributeLocation = glGetAttribLocation(shader->ProgramID, "i_uv");
+    glEnableVertexAttribArray(uvAttributeLocation);
+    glVertexAttribPointer(uvAttributeLocation, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid *)(sizeof(vec3) + sizeof(vec3)));
+
+    // TODO: Extended Feature, Texturing
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+    // Element indices only change when the cloth is replaced
+    const vector<GLuint>& vertexIndices = cloth->getVertexIndices();
+
+    if ((indexedCloth != cloth) || (indexCount != (GLsizei)vertexIndices.size())) {
+
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, vertexIndices.size() * sizeof(GLuint), &vertexIndices[0], GL_STATIC_DRAW);
+
+        indexedCloth = cloth;
+        indexCount = (GLsizei)vertexIndices.size();
+    }
+
+    //texture = loadTexture(TEX_PATH);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glUniform1i(glGetUniformLocation(shader->ProgramID, "i_texture"), 0);
+
+    const ParticleStore& particles = cloth->getParticles();
+    const vector<GLuint>& particleToGrid = cloth->getParticleGrid();
+
+    const GLsizei NumPX = cloth->getNumPX();
+    const GLsizei NumPY = cloth->getNumPY();
+    const GLsizei NumP = particles.size();
+
+    {
+        // CPU side cost only, the driver may defer the copy itself
+        PROFILE_SCOPE(cloth->getProfiler(), PROFILE_UPLOAD);
+
+        vertexData.resize(NumP);
+
+        // Vertices are streamed in particle storage order, the element indices hold particle indices
+        for (GLsizei k = 0; k < NumP; k++) {
+
+            GLsizei i = particleToGrid[k] % (NumPX + 1);
+            GLsizei j = particleToGrid[k] / (NumPX + 1);
+
+            Vertex& v = vertexData[k];
+            v.position = particles.position[k];
+            v.normal = particles.normal[k];
+            v.uv = vec2((i / NumPX), (j / NumPY));
+        }
+
+        glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(Vertex), value_ptr(vertexData[0].position), GL_STREAM_DRAW);
+    }
+
+    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+
+    // Deallocate Memory
+    glDeleteTextures(1, &texture);
+
+    glDisableVertexAttribArray(positionAttributeLocation);
+    glDisableVertexAttribArray(normalAttributeLocation);
+    glDisableVertexAttribArray(uvAttributeLocation);
+
+    glBindVertexArray(0);
+}
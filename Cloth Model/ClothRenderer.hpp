@@ -0,0 +1,65 @@
+// Header Guards
+#ifndef CLOTHRENDERER_HPP
+#define CLOTHRENDERER_HPP
+
+#pragma once
+
+// OpenGL Extensions Wrangler Library
+#include <GL/glew.h>
+
+// OpenGL Mathematics Library
+#include <GLM/glm.hpp>
+#include <GLM/gtc/type_ptr.hpp>
+
+// Simple OpenGL Image Loading Library
+//#include <SOIL.h>
+
+// C/C++ Standard Libraries
+#include <vector>
+
+// Internal Dependancies
+#include "Cloth.hpp"
+#include "Shader.hpp"
+
+#define TEX_PATH "4K_UJ_FLAG.png"
+
+// OpenGL drawing of a Cloth, the simulation core itself holds no GL state
+class ClothRenderer {
+
+public:
+
+    ClothRenderer(void);
+    ~ClothRenderer(void);
+
+    GLuint loadTexture(const char* path);
+
+    GLvoid setWire(GLboolean flag);
+
+    // Draw Vertex/Position Array, requires a current GL context
+    GLvoid render(Cloth* cloth, const Shader* shader);
+
+private:
+
+    struct Vertex {
+
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec2 uv;
+    };
+
+    std::vector<Vertex> vertexData;
+
+    const Cloth* indexedCloth;   // Cloth whose element indices are held by EBO
+    GLsizei indexCount;
+
+    GLboolean drawWire;
+
+    // GL Objects
+    GLuint TextureID;
+
+    GLuint VAO;
+    GLuint VBO;
+    GLuint EBO;
+};
+
+#endif /* ClothRenderer_hpp */
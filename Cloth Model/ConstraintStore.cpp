@@ -0,0 +1,39 @@
+#include "ConstraintStore.hpp"
+
+ConstraintStore::ConstraintStore(void)
+{
+}
+
+ConstraintStore::~ConstraintStore(void)
+{
+}
+
+GLvoid ConstraintStore::resize(GLsizei count) {
+
+    particleA.resize(count, 0);
+    particleB.resize(count, 0);
+    restLength.resize(count, 0.0f);
+    compliance.resize(count, 0.0f);
+    damping.resize(count, 0.0f);
+    lambda.resize(count, 0.0f);
+}
+
+GLvoid ConstraintStore::clear(void) {
+
+    particleA.clear();
+    particleB.clear();
+    restLength.clear();
+    compliance.clear();
+    damping.clear();
+    lambda.clear();
+
+    batches.clear();
+}
+
+GLsizei ConstraintStore::size(void) const {
+    return((GLsizei)particleA.size());
+}
+
+GLsizei ConstraintStore::getNumBatches(void) const {
+    return(batches.empty() ? 0 : (GLsizei)batches.size() - 1);
+}
@@ -0,0 +1,43 @@
+// Header Guards
+#ifndef CONSTRAINTSTORE_HPP
+#define CONSTRAINTSTORE_HPP
+
+#pragma once
+
+// OpenGL Scalar Types, see GLTypes.hpp
+#include "GLTypes.hpp"
+
+// C/C++ Standard Libraries
+#include <vector>
+
+// Internal Dependancies
+#include "ParticleStore.hpp"
+
+// Structure-of-arrays position constraint storage for the XPBD solver, see Cloth::PBD_ExtendedPositionBased
+// Constraints are stored grouped by colour, batch b is [batches[b], batches[b + 1]) and no two of its constraints share a
+// particle, so each batch streams through the arrays in order and is projected in parallel
+class ConstraintStore {
+
+public:
+
+    ConstraintStore(void);
+    ~ConstraintStore(void);
+
+    GLvoid resize(GLsizei count);
+    GLvoid clear(void);
+    GLsizei size(void) const;
+
+    GLsizei getNumBatches(void) const;
+
+    // Hot Streams, Constraint Projection
+    AlignedVector<GLuint> particleA;
+    AlignedVector<GLuint> particleB;
+    AlignedVector<GLfloat> restLength;
+    AlignedVector<GLfloat> compliance;  // XPBD compliance alpha, the inverse of the constraint stiffness
+    AlignedVector<GLfloat> damping;     // XPBD alpha beta, the compliance times the spring damping, gamma = damping / h
+    AlignedVector<GLfloat> lambda;      // Lagrange multiplier accumulated over the iterations of one substep
+
+    std::vector<GLsizei> batches;       // Per colour offsets, one past the last batch at the end
+};
+
+#endif /* ConstraintStore_hpp */
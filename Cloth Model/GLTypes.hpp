@@ -0,0 +1,25 @@
+// Header Guards
+#ifndef GLTYPES_HPP
+#define GLTYPES_HPP
+
+#pragma once
+
+// OpenGL scalar types for the simulation core, which never calls into OpenGL and so builds without GLEW or a GL context
+// Definitions match <GL/glew.h>, so the core headers may be included before or after it
+
+// C/C++ Standard Libraries
+#include <cstddef>
+#include <cstdint>
+
+typedef void GLvoid;
+typedef unsigned char GLboolean;
+typedef int GLint;
+typedef unsigned int GLuint;
+typedef int GLsizei;
+typedef float GLfloat;
+typedef uint64_t GLuint64;
+
+#define GL_FALSE 0
+#define GL_TRUE 1
+
+#endif /* GLTypes_hpp */
@@ -9,8 +9,8 @@
 #ifndef LargeVM_hpp
 #define LargeVM_hpp
 
-// OpenGL Extension Wrangler Library
-#include <GL/glew.h>
+// OpenGL Scalar Types, see GLTypes.hpp
+#include "GLTypes.hpp"
 
 // OpenGL Mathematics Library
 #include <GLM/glm.hpp>
@@ -18,10 +18,61 @@
 #include <GLM/gtc/type_ptr.hpp>
 
 // C/C++ Standard Libraries
+#include <algorithm>
+#include <cmath>
+#include <utility>
 #include <vector>
 
+#define LARGEVM_PARALLEL 4096   // Minimum elements before a loop or reduction is split across threads
+#define LARGEVM_CHUNK 1024      // Elements per reduction chunk, fixed so a reduction never depends on the thread count
+#define LARGEVM_CHUNKS 256      // Most chunks per reduction, longer vectors use proportionally longer chunks
+#define LARGEVM_LANES 8         // Independent accumulators per chunk, one per vector lane
+
+// Lazy expression templates, an expression such as x + alpha * d builds a small tree of nodes referring to its operands
+// and is evaluated element by element in a single loop when assigned to a LargeVM, no intermediate vectors are allocated
+// Element-wise operations read only element i of their operands, so such an expression may be assigned to one of them
+// The sparse product A * x of BlockSparseMatrix.hpp reads other elements of x and must never be assigned back into x
+template<class E, class T>
+class LargeVMExpr {
+    
+public:
+    
+    typedef T value_type;
+    
+    const E& self(void) const {
+        
+        return static_cast<const E&>(*this);
+    }
+    
+    T operator[](GLsizei i) const {
+        
+        return self()[i];
+    }
+    
+    GLsizei size(void) const {
+        
+        return self().size();
+    }
+};
+
+template<class T>
+class LargeVM;
+
+// Leaves are held by reference, expression nodes by value, the nodes of a full expression live until its end
+template<class E>
+struct LargeVMOperand {
+    
+    typedef const E type;
+};
+
 template<class T>
-class LargeVM {
+struct LargeVMOperand< LargeVM<T> > {
+    
+    typedef const LargeVM<T>& type;
+};
+
+template<class T>
+class LargeVM : public LargeVMExpr<LargeVM<T>, T> {
     
 private:
     
@@ -33,10 +84,38 @@ public:
         
     }
     
-    LargeVM(const LargeVM& other) {
+    LargeVM(const LargeVM& other) : _vec(other._vec) {
+        
+    }
+    
+    LargeVM(LargeVM&& other) : _vec(std::move(other._vec)) {
+        
+    }
+    
+    // Explicit, so a dot of a stored vector & an expression has the expression template as its only candidate
+    template<class E>
+    explicit LargeVM(const LargeVMExpr<E, T>& expr) {
+        
+        assign(expr.self());
+    }
+    
+    LargeVM& operator=(const LargeVM& other) {
+        
+        _vec = other._vec;
+        return *this;
+    }
+    
+    LargeVM& operator=(LargeVM&& other) {
+        
+        _vec = std::move(other._vec);
+        return *this;
+    }
+    
+    template<class E>
+    LargeVM& operator=(const LargeVMExpr<E, T>& expr) {
         
-        _vec.resize(other._vec.size());
-        memcpy(&_vec[0], &(other._vec[0]), sizeof(other._vec[0]) * other._vec.size());
+        assign(expr.self());
+        return *this;
     }
     
     GLvoid Resize(const GLsizei size) {
@@ -46,15 +125,12 @@ public:
     
     GLvoid Clear(GLboolean isIdentity = GL_FALSE) {
         
-        memset(&_vec[0], 0, sizeof(T) * _vec.size());
+        std::fill(_vec.begin(), _vec.end(), isIdentity ? T(1) : T(0));
+    }
+    
+    GLsizei size(void) const {
         
-        if (isIdentity) {
-            
-            for (GLsizei i = 0; i < _vec.size(); i++) {
-                
-                _vec[1] = T(0);
-            }
-        }
+        return (GLsizei)_vec.size();
     }
     
     T& operator[](GLuint index) {
@@ -62,23 +138,252 @@ public:
         return _vec[index];
     }
     
-    friend LargeVM<glm::vec3> operator*(const LargeVM<glm::mat3> other, const LargeVM<glm::vec3> v);
+    const T& operator[](GLuint index) const {
+        
+        return _vec[index];
+    }
     
-    friend LargeVM<glm::vec3> operator*(const GLfloat f, const LargeVM<glm::vec3> other);
+    const T* data(void) const {
+        
+        return _vec.data();
+    }
     
-    friend LargeVM<glm::vec3> operator-(const LargeVM<glm::vec3> vecA, const LargeVM<glm::vec3> vecB);
+private:
     
-    friend LargeVM<glm::vec3> operator*(const LargeVM<glm::vec3> vecA, const LargeVM<glm::vec3> vecB);
+    // Single fused evaluation loop, split across threads and vectorised, storage is only reallocated when the size changes
+    template<class E>
+    GLvoid assign(const E& expr) {
+        
+        const GLsizei n = expr.size();
+        
+        _vec.resize(n);
+        T* out = _vec.data();
+        
+        #pragma omp parallel for simd schedule(static) if (n >= LARGEVM_PARALLEL)
+        for (GLsizei i = 0; i < n; i++)
+            out[i] = expr[i];
+    }
+};
+
+// Expression Nodes
+template<class A, class B, class T>
+class LargeVMSum : public LargeVMExpr<LargeVMSum<A, B, T>, T> {
     
-    friend LargeVM<glm::vec3> operator+(const LargeVM<glm::vec3> vecA, const LargeVM<glm::vec3> vecB);
+public:
     
-    friend LargeVM<glm::mat3> operator*(const GLfloat f, const LargeVM<glm::mat3> other);
+    LargeVMSum(const A& a, const B& b) : a(a), b(b) {
+        
+    }
     
-    friend LargeVM<glm::mat3> operator-(const LargeVM<glm::mat3> vecA, const LargeVM<glm::mat3> vecB);
+    T operator[](GLsizei i) const {
+        
+        return a[i] + b[i];
+    }
     
-    friend LargeVM<glm::vec3> operator/(const GLfloat f, const LargeVM<glm::vec3> v);
+    GLsizei size(void) const {
+        
+        return a.size();
+    }
+    
+private:
     
-    friend GLfloat dot(const LargeVM<glm::vec3> vecA, const LargeVM<glm::vec3> vecB);
+    typename LargeVMOperand<A>::type a;
+    typename LargeVMOperand<B>::type b;
 };
 
+template<class A, class B, class T>
+class LargeVMDifference : public LargeVMExpr<LargeVMDifference<A, B, T>, T> {
+    
+public:
+    
+    LargeVMDifference(const A& a, const B& b) : a(a), b(b) {
+        
+    }
+    
+    T operator[](GLsizei i) const {
+        
+        return a[i] - b[i];
+    }
+    
+    GLsizei size(void) const {
+        
+        return a.size();
+    }
+    
+private:
+    
+    typename LargeVMOperand<A>::type a;
+    typename LargeVMOperand<B>::type b;
+};
+
+// Element-wise product, per particle mat3 * vec3 blocks or component-wise vec3 * vec3
+template<class A, class B, class T>
+class LargeVMProduct : public LargeVMExpr<LargeVMProduct<A, B, T>, T> {
+    
+public:
+    
+    LargeVMProduct(const A& a, const B& b) : a(a), b(b) {
+        
+    }
+    
+    T operator[](GLsizei i) const {
+        
+        return a[i] * b[i];
+    }
+    
+    GLsizei size(void) const {
+        
+        return b.size();
+    }
+    
+private:
+    
+    typename LargeVMOperand<A>::type a;
+    typename LargeVMOperand<B>::type b;
+};
+
+template<class A, class T>
+class LargeVMScale : public LargeVMExpr<LargeVMScale<A, T>, T> {
+    
+public:
+    
+    LargeVMScale(const A& a, GLfloat f) : a(a), f(f) {
+        
+    }
+    
+    T operator[](GLsizei i) const {
+        
+        return a[i] * f;
+    }
+    
+    GLsizei size(void) const {
+        
+        return a.size();
+    }
+    
+private:
+    
+    typename LargeVMOperand<A>::type a;
+    GLfloat f;
+};
+
+// Operators
+template<class A, class B, class T>
+inline LargeVMSum<A, B, T> operator+(const LargeVMExpr<A, T>& a, const LargeVMExpr<B, T>& b) {
+    
+    return LargeVMSum<A, B, T>(a.self(), b.self());
+}
+
+template<class A, class B, class T>
+inline LargeVMDifference<A, B, T> operator-(const LargeVMExpr<A, T>& a, const LargeVMExpr<B, T>& b) {
+    
+    return LargeVMDifference<A, B, T>(a.self(), b.self());
+}
+
+template<class A, class B>
+inline LargeVMProduct<A, B, glm::vec3> operator*(const LargeVMExpr<A, glm::mat3>& a, const LargeVMExpr<B, glm::vec3>& b) {
+    
+    return LargeVMProduct<A, B, glm::vec3>(a.self(), b.self());
+}
+
+template<class A, class B>
+inline LargeVMProduct<A, B, glm::vec3> operator*(const LargeVMExpr<A, glm::vec3>& a, const LargeVMExpr<B, glm::vec3>& b) {
+    
+    return LargeVMProduct<A, B, glm::vec3>(a.self(), b.self());
+}
+
+template<class A, class T>
+inline LargeVMScale<A, T> operator*(const GLfloat f, const LargeVMExpr<A, T>& a) {
+    
+    return LargeVMScale<A, T>(a.self(), f);
+}
+
+// NOTE, divides the vector by f, (f / v) reads as v / f
+template<class A, class T>
+inline LargeVMScale<A, T> operator/(const GLfloat f, const LargeVMExpr<A, T>& a) {
+    
+    return LargeVMScale<A, T>(a.self(), 1.0f / f);
+}
+
+// Pairwise (tree) summation in place, adjacent values are combined level by level
+template<class T>
+inline T LargeVMPairwiseSum(T* values, GLsizei n) {
+    
+    for (GLsizei stride = 1; stride < n; stride *= 2) {
+        
+        for (GLsizei i = 0; (i + stride) < n; i += (stride * 2))
+            values[i] += values[i + stride];
+    }
+    
+    return n ? values[0] : T(0);
+}
+
+// Deterministic sum of term(i) over [0, n), the range is cut into fixed chunks whatever the thread count, each chunk is
+// accumulated over LARGEVM_LANES interleaved lanes and the lane & chunk partial sums are combined pairwise in a fixed order
+// The sum takes the type of term(i), any type constructible from 0 with += will do, e.g. a vec3 or a struct of sums
+template<class Term>
+inline auto LargeVMReduce(GLsizei n, const Term& term) -> decltype(term(0)) {
+    
+    typedef decltype(term(0)) T;
+    
+    const GLsizei chunk = std::max(LARGEVM_CHUNK, (n + LARGEVM_CHUNKS - 1) / LARGEVM_CHUNKS);
+    const GLsizei numChunks = (n + chunk - 1) / chunk;
+    
+    T partial[LARGEVM_CHUNKS];
+    
+    #pragma omp parallel for schedule(static) if (n >= LARGEVM_PARALLEL)
+    for (GLsizei c = 0; c < numChunks; c++) {
+        
+        const GLsizei first = c * chunk;
+        const GLsizei last = std::min(first + chunk, n);
+        
+        T lanes[LARGEVM_LANES];
+        
+        for (GLsizei l = 0; l < LARGEVM_LANES; l++)
+            lanes[l] = T(0);
+        
+        GLsizei i = first;
+        
+        for (; (i + LARGEVM_LANES) <= last; i += LARGEVM_LANES) {
+            
+            for (GLsizei l = 0; l < LARGEVM_LANES; l++)
+                lanes[l] += term(i + l);
+        }
+        
+        for (GLsizei l = 0; i < last; i++, l++)
+            lanes[l] += term(i);
+        
+        partial[c] = LargeVMPairwiseSum(lanes, LARGEVM_LANES);
+    }
+    
+    return LargeVMPairwiseSum(partial, numChunks);
+}
+
+template<class A, class B>
+inline GLfloat dot(const LargeVMExpr<A, glm::vec3>& a, const LargeVMExpr<B, glm::vec3>& b) {
+    
+    const A& Va = a.self();
+    const B& Vb = b.self();
+    
+    return LargeVMReduce(Va.size(), [&](GLsizei i) { return glm::dot(Va[i], Vb[i]); }); // GLM Quaternion Dot Product
+}
+
+// Two stored vectors, & only those, are reduced as flat float streams, so whole vector registers are filled without shuffles
+inline GLfloat dot(const LargeVM<glm::vec3>& a, const LargeVM<glm::vec3>& b) {
+    
+    const GLfloat* Va = reinterpret_cast<const GLfloat*>(a.data());
+    const GLfloat* Vb = reinterpret_cast<const GLfloat*>(b.data());
+    
+    return LargeVMReduce(a.size() * 3, [=](GLsizei i) { return Va[i] * Vb[i]; });
+}
+
+template<class A>
+inline GLfloat norm(const LargeVMExpr<A, glm::vec3>& a) {
+    
+    return std::sqrt(dot(a, a));
+}
+
+extern template class LargeVM<glm::vec3>;
+extern template class LargeVM<glm::mat3>;
+
 #endif /* LargeVM_hpp */
@@ -0,0 +1,513 @@
+#include "Multigrid.hpp"
+
+// C/C++ Standard Libraries
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+using namespace glm;
+
+// Coarse points J interpolating fine point f along one axis and their bilinear weights, coarse point J lies on fine point 2J
+static inline GLsizei parents(GLsizei f, GLsizei nc, GLsizei* J, GLfloat* w) {
+
+    if (!(f & 1)) {
+
+        J[0] = f >> 1;
+        w[0] = 1.0f;
+
+        return(1);
+    }
+
+    GLsizei count = 0;
+
+    J[count] = f >> 1;
+    w[count++] = 0.5f;
+
+    if (((f >> 1) + 1) < nc) {
+
+        J[count] = (f >> 1) + 1;
+        w[count++] = 0.5f;
+    }
+
+    return(count);
+}
+
+// Couplings beyond the 5x5 stencil only arise from springs spanning more than two grid points, and are dropped
+static inline GLvoid stencilAdd(mat3* row, GLsizei dx, GLsizei dy, const mat3& block) {
+
+    if ((abs(dx) <= 2) && (abs(dy) <= 2))
+        row[((dy + 2) * 5) + (dx + 2)] += block;
+}
+
+Multigrid::Multigrid(void)
+{
+    A = NULL;
+    S = NULL;
+}
+
+Multigrid::~Multigrid(void)
+{
+}
+
+GLvoid Multigrid::build(GLsizei nx, GLsizei ny, const vector<GLuint>& g2p, const vector<GLuint>& p2g) {
+
+    clear();
+
+    gridToParticle = g2p;
+    particleToGrid = p2g;
+
+    const GLsizei NumP = nx * ny;
+
+    for (GLsizei p = 0; p < NumP; p++) {
+
+        GLuint g = particleToGrid[p];
+        colours[((g % nx) + (g / nx)) & 1].push_back(p);
+    }
+
+    constrained.assign(NumP, GL_FALSE);
+
+    Level fine;
+
+    fine.nx = nx;
+    fine.ny = ny;
+    fine.diagonalInverse.resize(NumP);
+    fine.residual.resize(NumP);
+    fine.scratch.resize(NumP);
+
+    levels.push_back(fine);
+
+    while (glm::min(nx, ny) > MULTIGRID_COARSEST) {
+
+        nx = (nx + 1) / 2;
+        ny = (ny + 1) / 2;
+
+        Level coarse;
+
+        coarse.nx = nx;
+        coarse.ny = ny;
+        coarse.stencil.resize(nx * ny * MULTIGRID_STENCIL);
+        coarse.diagonalInverse.resize(nx * ny);
+        coarse.r.resize(nx * ny);
+        coarse.e.resize(nx * ny);
+        coarse.residual.resize(nx * ny);
+        coarse.scratch.resize(nx * ny);
+
+        levels.push_back(coarse);
+    }
+}
+
+GLvoid Multigrid::clear(void) {
+
+    vector<Level>().swap(levels);
+
+    vector<GLuint>().swap(gridToParticle);
+    vector<GLuint>().swap(particleToGrid);
+    vector<GLuint>().swap(colours[0]);
+    vector<GLuint>().swap(colours[1]);
+    vector<GLboolean>().swap(constrained);
+
+    A = NULL;
+    S = NULL;
+}
+
+GLsizei Multigrid::getRows(void) const {
+    return(levels.empty() ? 0 : (levels[0].nx * levels[0].ny));
+}
+
+GLsizei Multigrid::getLevels(void) const {
+    return((GLsizei)levels.size());
+}
+
+// Block k of the filtered system, S_a A_ab S_b, plus I - S_a on the diagonal so constrained directions stay invertible
+inline mat3 Multigrid::filteredBlock(GLuint k, GLuint a, GLuint b) const {
+
+    mat3 block = A->block(k);
+
+    if (constrained[a] || constrained[b])
+        block = S[a] * block * S[b];
+
+    if ((a == b) && constrained[a])
+        block += mat3(1) - S[a];
+
+    return(block);
+}
+
+GLvoid Multigrid::setup(const BlockSparseMatrix& matrix, const mat3* filter) {
+
+    A = &matrix;
+    S = filter;
+
+    Level& fine = levels[0];
+    const GLsizei NumP = fine.nx * fine.ny;
+
+    #pragma omp parallel for schedule(static) if (NumP >= MULTIGRID_PARALLEL)
+    for (GLsizei p = 0; p < NumP; p++) {
+
+        constrained[p] = (S[p] != mat3(1));
+        fine.diagonalInverse[p] = inverse(filteredBlock(A->getDiagonal(p), p, p));
+    }
+
+    if (levels.size() > 1)
+        galerkinFine();
+
+    for (GLsizei level = 1; level < (GLsizei)levels.size() - 1; level++)
+        galerkinCoarse(level);
+}
+
+// R A P from the fine block sparse rows, each coarse node gathers the rows of the fine points it restricts from
+GLvoid Multigrid::galerkinFine(void) {
+
+    const Level& fine = levels[0];
+    Level& coarse = levels[1];
+
+    const GLsizei NumC = coarse.nx * coarse.ny;
+
+    #pragma omp parallel for schedule(static) if (NumC >= MULTIGRID_PARALLEL)
+    for (GLsizei n = 0; n < NumC; n++) {
+
+        const GLsizei X = n % coarse.nx;
+        const GLsizei Y = n / coarse.nx;
+
+        mat3 row[MULTIGRID_STENCIL];
+
+        for (GLsizei s = 0; s < MULTIGRID_STENCIL; s++)
+            row[s] = mat3(0);
+
+        for (GLsizei ay = -1; ay <= 1; ay++) {
+
+            const GLsizei fy = (2 * Y) + ay;
+
+            if ((fy < 0) || (fy >= fine.ny))
+                continue;
+
+            for (GLsizei ax = -1; ax <= 1; ax++) {
+
+                const GLsizei fx = (2 * X) + ax;
+
+                if ((fx < 0) || (fx >= fine.nx))
+                    continue;
+
+                // Full weighting, R = P^T / 4
+                const GLfloat wa = 0.25f * (ax ? 0.5f : 1.0f) * (ay ? 0.5f : 1.0f);
+                const GLuint a = gridToParticle[fx + (fy * fine.nx)];
+
+                for (GLuint k = A->getRowBegin(a); k < A->getRowEnd(a); k++) {
+
+                    const GLuint b = A->getColumn(k);
+                    const GLuint g = particleToGrid[b];
+
+                    GLsizei Jx[2], Jy[2];
+                    GLfloat wx[2], wy[2];
+
+                    GLsizei cx = parents(g % fine.nx, coarse.nx, Jx, wx);
+                    GLsizei cy = parents(g / fine.nx, coarse.ny, Jy, wy);
+
+                    const mat3 block = wa * filteredBlock(k, a, b);
+
+                    for (GLsizei j = 0; j < cy; j++) {
+                        for (GLsizei i = 0; i < cx; i++)
+                            stencilAdd(row, Jx[i] - X, Jy[j] - Y, (wx[i] * wy[j]) * block);
+                    }
+                }
+            }
+        }
+
+        for (GLsizei s = 0; s < MULTIGRID_STENCIL; s++)
+            coarse.stencil[(n * MULTIGRID_STENCIL) + s] = row[s];
+
+        coarse.diagonalInverse[n] = inverse(row[12]);
+    }
+}
+
+// R A P between two stencil levels
+GLvoid Multigrid::galerkinCoarse(GLsizei level) {
+
+    const Level& fine = levels[level];
+    Level& coarse = levels[level + 1];
+
+    const GLsizei NumC = coarse.nx * coarse.ny;
+
+    #pragma omp parallel for schedule(static) if (NumC >= MULTIGRID_PARALLEL)
+    for (GLsizei n = 0; n < NumC; n++) {
+
+        const GLsizei X = n % coarse.nx;
+        const GLsizei Y = n / coarse.nx;
+
+        mat3 row[MULTIGRID_STENCIL];
+
+        for (GLsizei s = 0; s < MULTIGRID_STENCIL; s++)
+            row[s] = mat3(0);
+
+        for (GLsizei ay = -1; ay <= 1; ay++) {
+
+            const GLsizei fy = (2 * Y) + ay;
+
+            if ((fy < 0) || (fy >= fine.ny))
+                continue;
+
+            for (GLsizei ax = -1; ax <= 1; ax++) {
+
+                const GLsizei fx = (2 * X) + ax;
+
+                if ((fx < 0) || (fx >= fine.nx))
+                    continue;
+
+                const GLfloat wa = 0.25f * (ax ? 0.5f : 1.0f) * (ay ? 0.5f : 1.0f);
+                const mat3* fineRow = &fine.stencil[(fx + (fy * fine.nx)) * MULTIGRID_STENCIL];
+
+                for (GLsizei s = 0; s < MULTIGRID_STENCIL; s++) {
+
+                    const GLsizei bx = fx + (s % 5) - 2;
+                    const GLsizei by = fy + (s / 5) - 2;
+
+                    if ((bx < 0) || (bx >= fine.nx) || (by < 0) || (by >= fine.ny))
+                        continue;
+
+                    GLsizei Jx[2], Jy[2];
+                    GLfloat wx[2], wy[2];
+
+                    GLsizei cx = parents(bx, coarse.nx, Jx, wx);
+                    GLsizei cy = parents(by, coarse.ny, Jy, wy);
+
+                    const mat3 block = wa * fineRow[s];
+
+                    for (GLsizei j = 0; j < cy; j++) {
+                        for (GLsizei i = 0; i < cx; i++)
+                            stencilAdd(row, Jx[i] - X, Jy[j] - Y, (wx[i] * wy[j]) * block);
+                    }
+                }
+            }
+        }
+
+        for (GLsizei s = 0; s < MULTIGRID_STENCIL; s++)
+            coarse.stencil[(n * MULTIGRID_STENCIL) + s] = row[s];
+
+        coarse.diagonalInverse[n] = inverse(row[12]);
+    }
+}
+
+// One red-black block Gauss-Seidel sweep, the nodes of a colour are solved together from the values before the colour's
+// update, so a sweep is the same whatever the thread count
+GLvoid Multigrid::smooth(GLsizei level, const vec3* r, vec3* e) {
+
+    Level& l = levels[level];
+
+    for (GLsizei colour = 0; colour < 2; colour++) {
+
+        if (!level) {
+
+            const GLuint* particles = &colours[colour][0];
+            const GLsizei count = (GLsizei)colours[colour].size();
+
+            #pragma omp parallel for schedule(static) if (count >= MULTIGRID_PARALLEL)
+            for (GLsizei i = 0; i < count; i++) {
+
+                const GLuint p = particles[i];
+
+                vec3 sum = vec3(0);
+
+                for (GLuint k = A->getRowBegin(p); k < A->getRowEnd(p); k++) {
+
+                    const GLuint q = A->getColumn(k);
+
+                    if (q != p)
+                        sum += A->block(k) * e[q];
+                }
+
+                // Corrections lie in the unconstrained directions, S_p A S_q e_q = S_p A e_q
+                if (constrained[p])
+                    sum = S[p] * sum;
+
+                l.scratch[p] = l.diagonalInverse[p] * (r[p] - sum);
+            }
+
+            #pragma omp parallel for schedule(static) if (count >= MULTIGRID_PARALLEL)
+            for (GLsizei i = 0; i < count; i++)
+                e[particles[i]] = l.scratch[particles[i]];
+        }
+        else {
+
+            #pragma omp parallel for schedule(static) if ((l.nx * l.ny) >= MULTIGRID_PARALLEL)
+            for (GLsizei y = 0; y < l.ny; y++) {
+
+                for (GLsizei x = (y + colour) & 1; x < l.nx; x += 2) {
+
+                    const GLsizei n = x + (y * l.nx);
+                    const mat3* row = &l.stencil[n * MULTIGRID_STENCIL];
+
+                    vec3 sum = vec3(0);
+
+                    for (GLsizei s = 0; s < MULTIGRID_STENCIL; s++) {
+
+                        const GLsizei bx = x + (s % 5) - 2;
+                        const GLsizei by = y + (s / 5) - 2;
+
+                        if ((s != 12) && (bx >= 0) && (bx < l.nx) && (by >= 0) && (by < l.ny))
+                            sum += row[s] * e[bx + (by * l.nx)];
+                    }
+
+                    l.scratch[n] = l.diagonalInverse[n] * (r[n] - sum);
+                }
+            }
+
+            #pragma omp parallel for schedule(static) if ((l.nx * l.ny) >= MULTIGRID_PARALLEL)
+            for (GLsizei y = 0; y < l.ny; y++) {
+
+                for (GLsizei x = (y + colour) & 1; x < l.nx; x += 2)
+                    e[x + (y * l.nx)] = l.scratch[x + (y * l.nx)];
+            }
+        }
+    }
+}
+
+GLvoid Multigrid::computeResidual(GLsizei level, const vec3* r, const vec3* e) {
+
+    Level& l = levels[level];
+    const GLsizei NumN = l.nx * l.ny;
+
+    if (!level) {
+
+        #pragma omp parallel for schedule(static) if (NumN >= MULTIGRID_PARALLEL)
+        for (GLsizei p = 0; p < NumN; p++) {
+
+            vec3 Ae = A->multiplyRow(p, e);
+
+            l.residual[p] = r[p] - (constrained[p] ? (S[p] * Ae) : Ae);
+        }
+
+        return;
+    }
+
+    #pragma omp parallel for schedule(static) if (NumN >= MULTIGRID_PARALLEL)
+    for (GLsizei n = 0; n < NumN; n++) {
+
+        const GLsizei x = n % l.nx;
+        const GLsizei y = n / l.nx;
+        const mat3* row = &l.stencil[n * MULTIGRID_STENCIL];
+
+        vec3 Ae = vec3(0);
+
+        for (GLsizei s = 0; s < MULTIGRID_STENCIL; s++) {
+
+            const GLsizei bx = x + (s % 5) - 2;
+            const GLsizei by = y + (s / 5) - 2;
+
+            if ((bx >= 0) && (bx < l.nx) && (by >= 0) && (by < l.ny))
+                Ae += row[s] * e[bx + (by * l.nx)];
+        }
+
+        l.residual[n] = r[n] - Ae;
+    }
+}
+
+// Full weighting of the residual of level onto the right hand side of the next level
+GLvoid Multigrid::restrictResidual(GLsizei level) {
+
+    const Level& fine = levels[level];
+    Level& coarse = levels[level + 1];
+
+    const GLsizei NumC = coarse.nx * coarse.ny;
+
+    #pragma omp parallel for schedule(static) if (NumC >= MULTIGRID_PARALLEL)
+    for (GLsizei n = 0; n < NumC; n++) {
+
+        const GLsizei X = n % coarse.nx;
+        const GLsizei Y = n / coarse.nx;
+
+        vec3 sum = vec3(0);
+
+        for (GLsizei ay = -1; ay <= 1; ay++) {
+
+            const GLsizei fy = (2 * Y) + ay;
+
+            if ((fy < 0) || (fy >= fine.ny))
+                continue;
+
+            for (GLsizei ax = -1; ax <= 1; ax++) {
+
+                const GLsizei fx = (2 * X) + ax;
+
+                if ((fx < 0) || (fx >= fine.nx))
+                    continue;
+
+                GLuint a = fx + (fy * fine.nx);
+
+                if (!level)
+                    a = gridToParticle[a];
+
+                sum += (0.25f * (ax ? 0.5f : 1.0f) * (ay ? 0.5f : 1.0f)) * fine.residual[a];
+            }
+        }
+
+        coarse.r[n] = sum;
+    }
+}
+
+// Bilinear interpolation of the next level's correction, added to the correction of level
+GLvoid Multigrid::prolongCorrection(GLsizei level, vec3* e) {
+
+    const Level& fine = levels[level];
+    const Level& coarse = levels[level + 1];
+
+    const GLsizei NumN = fine.nx * fine.ny;
+
+    #pragma omp parallel for schedule(static) if (NumN >= MULTIGRID_PARALLEL)
+    for (GLsizei n = 0; n < NumN; n++) {
+
+        const GLuint g = level ? n : particleToGrid[n];
+
+        GLsizei Jx[2], Jy[2];
+        GLfloat wx[2], wy[2];
+
+        GLsizei cx = parents(g % fine.nx, coarse.nx, Jx, wx);
+        GLsizei cy = parents(g / fine.nx, coarse.ny, Jy, wy);
+
+        vec3 sum = vec3(0);
+
+        for (GLsizei j = 0; j < cy; j++) {
+            for (GLsizei i = 0; i < cx; i++)
+                sum += (wx[i] * wy[j]) * coarse.e[Jx[i] + (Jy[j] * coarse.nx)];
+        }
+
+        // The fine correction keeps to the unconstrained directions
+        if (!level && constrained[n])
+            sum = S[n] * sum;
+
+        e[n] += sum;
+    }
+}
+
+GLvoid Multigrid::cycleLevel(Cycle type, GLsizei level, const vec3* r, vec3* e) {
+
+    if (level == (GLsizei)levels.size() - 1) {
+
+        for (GLsizei k = 0; k < MULTIGRID_COARSE_SWEEPS; k++)
+            smooth(level, r, e);
+
+        return;
+    }
+
+    for (GLsizei k = 0; k < MULTIGRID_SMOOTHING; k++)
+        smooth(level, r, e);
+
+    computeResidual(level, r, e);
+    restrictResidual(level);
+
+    Level& coarse = levels[level + 1];
+    std::fill(coarse.e.begin(), coarse.e.end(), vec3(0));
+
+    for (GLsizei k = 0; k < (GLsizei)type; k++)
+        cycleLevel(type, level + 1, &coarse.r[0], &coarse.e[0]);
+
+    prolongCorrection(level, e);
+
+    for (GLsizei k = 0; k < MULTIGRID_SMOOTHING; k++)
+        smooth(level, r, e);
+}
+
+GLvoid Multigrid::cycle(Cycle type, const vec3* r, vec3* e) {
+
+    std::fill(e, e + getRows(), vec3(0));
+
+    cycleLevel(type, 0, r, e);
+}
@@ -0,0 +1,93 @@
+// Header Guards
+#ifndef MULTIGRID_HPP
+#define MULTIGRID_HPP
+
+#pragma once
+
+// OpenGL Scalar Types, see GLTypes.hpp
+#include "GLTypes.hpp"
+
+// OpenGL Mathematics Library
+#include <GLM/glm.hpp>
+
+// C/C++ Standard Libraries
+#include <vector>
+
+// Internal Dependancies
+#include "BlockSparseMatrix.hpp"
+
+#define MULTIGRID_PARALLEL 4096     // Minimum nodes before a level's sweeps are split across threads
+#define MULTIGRID_COARSEST 3        // Coarsening stops once either grid dimension is this small
+#define MULTIGRID_SMOOTHING 2       // Red-black sweeps before & after each coarse grid correction
+#define MULTIGRID_COARSE_SWEEPS 16  // Red-black sweeps standing in for a direct solve on the coarsest level
+#define MULTIGRID_STENCIL 25        // Coarse operators couple nodes up to two grid points apart, a 5x5 stencil of 3x3 blocks
+
+// Geometric multigrid for the implicit system of the cloth lattice
+// The fine level is the assembled BlockSparseMatrix in particle order, each coarse level halves the lattice in both
+// directions and keeps its Galerkin operator R A P as a dense 5x5 block stencil per node, with full weighting restriction
+// R and bilinear prolongation P = 4 R^T. The constraint filter S of Baraff & Witkin [1998] is applied on the fine level,
+// corrections never leave the unconstrained directions
+class Multigrid {
+
+public:
+
+    enum Cycle {
+
+        V_CYCLE = 1,        // One coarse grid correction per level
+        W_CYCLE = 2         // Two coarse grid corrections per level
+    };
+
+    Multigrid(void);
+    ~Multigrid(void);
+
+    // Level hierarchy of an nx by ny lattice, grid point x + y * nx holds particle gridToParticle[x + y * nx]
+    GLvoid build(GLsizei nx, GLsizei ny, const std::vector<GLuint>& gridToParticle, const std::vector<GLuint>& particleToGrid);
+    GLvoid clear(void);
+
+    GLsizei getRows(void) const;
+    GLsizei getLevels(void) const;
+
+    // Refills the smoothers & coarse operators of the filtered system S A S + (I - S), once per step
+    GLvoid setup(const BlockSparseMatrix& A, const glm::mat3* S);
+
+    // e ≈ (S A S + I - S)^-1 r by a single cycle from e = 0, r must lie in the unconstrained directions
+    GLvoid cycle(Cycle type, const glm::vec3* r, glm::vec3* e);
+
+private:
+
+    struct Level {
+
+        GLsizei nx, ny;
+
+        std::vector<glm::mat3> stencil;         // Coarse levels, block of offset (dx, dy) at (dy + 2) * 5 + (dx + 2)
+        std::vector<glm::mat3> diagonalInverse; // Inverse of each diagonal block, the block Gauss-Seidel solve
+
+        std::vector<glm::vec3> r, e;            // Right hand side & correction of the coarse levels
+        std::vector<glm::vec3> residual;        // Residual restricted to the next level
+        std::vector<glm::vec3> scratch;         // New values of one colour, same colour couplings read the old values
+    };
+
+    GLvoid galerkinFine(void);
+    GLvoid galerkinCoarse(GLsizei level);
+
+    GLvoid smooth(GLsizei level, const glm::vec3* r, glm::vec3* e);
+    GLvoid computeResidual(GLsizei level, const glm::vec3* r, const glm::vec3* e);
+    GLvoid restrictResidual(GLsizei level);
+    GLvoid prolongCorrection(GLsizei level, glm::vec3* e);
+    GLvoid cycleLevel(Cycle type, GLsizei level, const glm::vec3* r, glm::vec3* e);
+
+    inline glm::mat3 filteredBlock(GLuint k, GLuint a, GLuint b) const;
+
+    std::vector<Level> levels;
+
+    std::vector<GLuint> gridToParticle;
+    std::vector<GLuint> particleToGrid;
+    std::vector<GLuint> colours[2];         // Fine level particles of each red-black colour, (x + y) & 1
+
+    std::vector<GLboolean> constrained;     // Fine level particles whose filter is not the identity
+
+    const BlockSparseMatrix* A;
+    const glm::mat3* S;
+};
+
+#endif /* Multigrid_hpp */
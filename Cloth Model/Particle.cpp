@@ -3,28 +3,12 @@
 using namespace glm;
 
 
-Particle::Particle(void)
+Particle::Particle(void) : _store(NULL), _particleIndex(0)
 {
 }
 
-Particle::Particle(vec3 pos) : _position(pos), _lastPos(pos) {
-    
-    _mass = 5.0f;
-    
-    _velocity = vec3(NULL);
-    _lastVel = _velocity;
-    
-    _acceleration =  vec3(NULL);
-    _force = vec3(NULL);
-    
-    _accumulatedNormal = vec3(NULL);
-    
-    _movable = GL_TRUE;
-    _fixedFlag = GL_FALSE;
-    
-    _collision = GL_FALSE;
-    
-    _particleIndex = NULL;
+Particle::Particle(ParticleStore* store, GLuint index) : _store(store), _particleIndex(index)
+{
 }
 
 Particle::~Particle(void)
@@ -32,123 +16,109 @@ Particle::~Particle(void)
 }
 
 GLvoid Particle::setPosition(vec3 pos) {
-    if (_movable) {
-        _position = pos;
+    if (_store->movable[_particleIndex]) {
+        _store->position[_particleIndex] = pos;
     }
 }
 
 GLvoid Particle::setVelocity(vec3 vel) {
-    _velocity = vel;
+    _store->velocity[_particleIndex] = vel;
 }
 
 GLvoid Particle::setNewPosition(vec3 pos) {
-    if (_movable) {
-        vec3 buffer = _position;
-        _position = pos;
-        _lastPos = buffer;
+    if (_store->movable[_particleIndex]) {
+        _store->lastPosition[_particleIndex] = _store->position[_particleIndex];
+        _store->position[_particleIndex] = pos;
     }
 }
 
 GLvoid Particle::offsetPosition(vec3 pos) {
-    _position = _position + pos;
+    _store->position[_particleIndex] += pos;
 }
 
 GLvoid Particle::setNewVelocity(vec3 vel) {
     
-    vec3 buffer = _velocity;
-    _velocity = vel;
-    _lastVel = buffer;
+    _store->lastVelocity[_particleIndex] = _store->velocity[_particleIndex];
+    _store->velocity[_particleIndex] = vel;
 }
 
 GLvoid Particle::offsetVelocity(vec3 vel) {
-    _velocity = _velocity + vel;
+    _store->velocity[_particleIndex] += vel;
 }
 
 vec3& Particle::getPosition(void) {
-    return _position;
+    return _store->position[_particleIndex];
 }
 
 vec3& Particle::getLPosition(void) {
-    return _lastPos;
+    return _store->lastPosition[_particleIndex];
 }
 
 GLvoid Particle::setFlag(GLboolean f) {
-    _movable = !(f);
+    _store->movable[_particleIndex] = !(f);
 }
 
-GLboolean& Particle::getFlag(void) {
-    return _movable;
+GLboolean Particle::getFlag(void) {
+    return _store->movable[_particleIndex];
 }
 
-GLfloat& Particle::getMass(void) {
-    return _mass;
+GLfloat Particle::getMass(void) {
+    return (1.0f / _store->invMass[_particleIndex]);
 }
 
 GLvoid Particle::setMass(GLfloat m) {
-    _mass = m;
+    _store->invMass[_particleIndex] = 1.0f / m;
 }
 
 vec3& Particle::getVelocity(void) {
-    return _velocity;
+    return _store->velocity[_particleIndex];
 }
 
 vec3& Particle::getLVelocity(void) {
-    return _lastVel;
-}
-
-inline GLvoid Particle::calcAcceleration(void) {
-    _acceleration = _force / _mass;
+    return _store->lastVelocity[_particleIndex];
 }
 
 GLvoid Particle::resetForce(void) {
-    _force = vec3(0);
-    _acceleration = vec3(0);
+    _store->force[_particleIndex] = vec3(0);
 }
 
 GLvoid Particle::setForce(vec3 f) {
-    _force = f;
-    _acceleration = f / _mass;
+    _store->force[_particleIndex] = f;
 }
 
 GLvoid Particle::addForce(vec3 f) {
-    _force += f;
-    _acceleration += f / _mass;
+    _store->force[_particleIndex] += f;
 }
 
 vec3& Particle::getForce(void) {
-    return _force;
+    return _store->force[_particleIndex];
 }
 
-vec3& Particle::getAcceleration(void) {
-    return _acceleration;
+// Acceleration is no longer stored, it is derived from the accumulated force
+vec3 Particle::getAcceleration(void) {
+    return (_store->force[_particleIndex] * _store->invMass[_particleIndex]);
 }
 
 GLvoid Particle::resetNormal(void) {
-    _accumulatedNormal = vec3(0);
+    _store->normal[_particleIndex] = vec3(0);
 }
 
 GLvoid Particle::addToNormal(vec3 n) {
-    _accumulatedNormal += normalize(n);
+    _store->normal[_particleIndex] += normalize(n);
 }
 
 vec3& Particle::getNormal(void) {
-    return _accumulatedNormal;
+    return _store->normal[_particleIndex];
 }
 
-GLvoid Particle::setIndex(GLuint in) {
-    _particleIndex = in;
-}
-
-GLuint& Particle::getIndex(void) {
+GLuint Particle::getIndex(void) {
     return _particleIndex;
 }
 
 GLvoid Particle::setCol(GLboolean flag) {
-    _collision = flag;
+    _store->collision[_particleIndex] = flag;
 }
 
-GLboolean& Particle::getCollFlag(void) {
-    return _collision;
+GLboolean Particle::getCollFlag(void) {
+    return _store->collision[_particleIndex];
 }
-
-
@@ -4,18 +4,22 @@
 
 #pragma once
 
-// OpenGL Extensions Wrangler Library
-#include <GL/glew.h>
+// OpenGL Scalar Types, see GLTypes.hpp
+#include "GLTypes.hpp"
 
 // OpenGL Mathematics Library
 #include <GLM/glm.hpp>
 
+// Internal Dependancies
+#include "ParticleStore.hpp"
+
+// Thin accessor view onto a single particle held by a ParticleStore
 class Particle {
     
 public:
     
     Particle(void);
-    Particle(glm::vec3 pos);
+    Particle(ParticleStore* store, GLuint index);
     ~Particle(void);
     
     GLvoid setNewPosition(glm::vec3 pos);
@@ -35,46 +39,28 @@ public:
     GLvoid addForce(glm::vec3 f);
     GLvoid resetForce(void);
     glm::vec3& getForce(void);
-    glm::vec3& getAcceleration(void);
+    glm::vec3 getAcceleration(void);
     
     GLvoid setMass(GLfloat m);
-    GLfloat& getMass(void);
+    GLfloat getMass(void);
     
     GLvoid addToNormal(glm::vec3 n);
     GLvoid resetNormal(void);
     glm::vec3& getNormal(void);
     
     GLvoid setFlag(GLboolean flag);
-    GLboolean& getFlag(void);
+    GLboolean getFlag(void);
     
     GLvoid setCol(GLboolean flag);
-    GLboolean& getCollFlag(void);
-    
-    inline GLvoid calcAcceleration(void);
+    GLboolean getCollFlag(void);
     
-    GLvoid setIndex(GLuint in);
-    GLuint& getIndex(void);
+    GLuint getIndex(void);
     
 private:
     
-    glm::vec3 _position;
-    glm::vec3 _lastPos;
-    glm::vec3 _velocity;
-    glm::vec3 _lastVel;
-    
-    GLfloat _mass;
-    
-    glm::vec3 _acceleration;
-    glm::vec3 _force;
-    
-    glm::vec3 _accumulatedNormal;
-    
-    GLboolean _movable;
-    GLboolean _fixedFlag;
-    
-    GLboolean _collision;
+    ParticleStore* _store;
     
     GLuint _particleIndex;
 };
 
-#endif /* Particles_hpp */
\ No newline at end of file
+#endif /* Particles_hpp */
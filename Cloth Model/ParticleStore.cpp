@@ -0,0 +1,90 @@
+#include "ParticleStore.hpp"
+
+using namespace glm;
+
+template<class T>
+static GLvoid permuteStream(AlignedVector<T>& stream, const std::vector<GLuint>& remap) {
+
+    AlignedVector<T> permuted(stream.size());
+
+    for (std::size_t i = 0; i < stream.size(); i++)
+        permuted[remap[i]] = stream[i];
+
+    stream.swap(permuted);
+}
+
+ParticleStore::ParticleStore(void)
+{
+}
+
+ParticleStore::~ParticleStore(void)
+{
+}
+
+GLvoid ParticleStore::resize(GLsizei count) {
+
+    position.resize(count, vec3(0));
+    lastPosition.resize(count, vec3(0));
+    velocity.resize(count, vec3(0));
+    lastVelocity.resize(count, vec3(0));
+    force.resize(count, vec3(0));
+
+    invMass.resize(count, 0.0f);
+    movable.resize(count, GL_TRUE);
+
+    normal.resize(count, vec3(0));
+    collision.resize(count, GL_FALSE);
+    contactNormal.resize(count, vec3(0));
+}
+
+GLvoid ParticleStore::clear(void) {
+
+    position.clear();
+    lastPosition.clear();
+    velocity.clear();
+    lastVelocity.clear();
+    force.clear();
+
+    invMass.clear();
+    movable.clear();
+
+    normal.clear();
+    collision.clear();
+    contactNormal.clear();
+}
+
+GLsizei ParticleStore::size(void) const {
+    return((GLsizei)position.size());
+}
+
+GLvoid ParticleStore::initParticle(GLuint i, vec3 pos, GLfloat mass) {
+
+    position[i] = pos;
+    lastPosition[i] = pos;
+    velocity[i] = vec3(0);
+    lastVelocity[i] = vec3(0);
+    force[i] = vec3(0);
+
+    invMass[i] = 1.0f / mass;
+    movable[i] = GL_TRUE;
+
+    normal[i] = vec3(0);
+    collision[i] = GL_FALSE;
+    contactNormal[i] = vec3(0);
+}
+
+GLvoid ParticleStore::permute(const std::vector<GLuint>& remap) {
+
+    permuteStream(position, remap);
+    permuteStream(lastPosition, remap);
+    permuteStream(velocity, remap);
+    permuteStream(lastVelocity, remap);
+    permuteStream(force, remap);
+
+    permuteStream(invMass, remap);
+    permuteStream(movable, remap);
+
+    permuteStream(normal, remap);
+    permuteStream(collision, remap);
+    permuteStream(contactNormal, remap);
+}
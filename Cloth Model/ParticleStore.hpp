@@ -0,0 +1,100 @@
+// Header Guards
+#ifndef PARTICLESTORE_HPP
+#define PARTICLESTORE_HPP
+
+#pragma once
+
+// OpenGL Scalar Types, see GLTypes.hpp
+#include "GLTypes.hpp"
+
+// OpenGL Mathematics Library
+#include <GLM/glm.hpp>
+
+// C/C++ Standard Libraries
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#define STREAM_ALIGNMENT 64 // Cache line size
+
+// Allocator returning cache line aligned storage, so that each particle stream begins on its own line
+template<class T, std::size_t Alignment = STREAM_ALIGNMENT>
+struct AlignedAllocator {
+
+    typedef T value_type;
+
+    template<class U>
+    struct rebind {
+        typedef AlignedAllocator<U, Alignment> other;
+    };
+
+    AlignedAllocator(void) {
+    }
+
+    template<class U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {
+    }
+
+    T* allocate(std::size_t n) {
+
+        GLvoid* ptr = NULL;
+
+        if (posix_memalign(&ptr, Alignment, n * sizeof(T)) != 0)
+            throw std::bad_alloc();
+
+        return(static_cast<T*>(ptr));
+    }
+
+    GLvoid deallocate(T* ptr, std::size_t) {
+        free(ptr);
+    }
+};
+
+template<class T, class U, std::size_t A>
+inline bool operator==(const AlignedAllocator<T, A>&, const AlignedAllocator<U, A>&) {
+    return(true);
+}
+
+template<class T, class U, std::size_t A>
+inline bool operator!=(const AlignedAllocator<T, A>&, const AlignedAllocator<U, A>&) {
+    return(false);
+}
+
+template<class T>
+using AlignedVector = std::vector<T, AlignedAllocator<T> >;
+
+// Structure-of-arrays particle storage, each integrator pass streams only the fields it touches
+class ParticleStore {
+
+public:
+
+    ParticleStore(void);
+    ~ParticleStore(void);
+
+    GLvoid resize(GLsizei count);
+    GLvoid clear(void);
+    GLsizei size(void) const;
+
+    GLvoid initParticle(GLuint index, glm::vec3 pos, GLfloat mass);
+
+    // Moves particle i to remap[i] in every stream
+    GLvoid permute(const std::vector<GLuint>& remap);
+
+    // Hot Streams, Integration & Force Passes
+    AlignedVector<glm::vec3> position;
+    AlignedVector<glm::vec3> lastPosition;
+    AlignedVector<glm::vec3> velocity;
+    AlignedVector<glm::vec3> lastVelocity;
+    AlignedVector<glm::vec3> force;
+
+    AlignedVector<GLfloat> invMass;
+    AlignedVector<GLboolean> movable;   // Pin flags, GL_FALSE for fixed particles
+
+    // Cold Streams, Rendering & Collision Passes
+    AlignedVector<glm::vec3> normal;
+    AlignedVector<GLboolean> collision; // Set by the collision passes, holds for the following step
+    AlignedVector<glm::vec3> contactNormal; // Constrained direction of a colliding particle, see Cloth::SolvePCCG
+};
+
+#endif /* ParticleStore_hpp */
@@ -0,0 +1,198 @@
+#include "Profiler.hpp"
+
+// C/C++ Standard Libraries
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Slot of the calling thread in every profiler's ring table, assigned on its first sample
+static std::atomic<GLint> nextThreadSlot(0);
+static __thread GLint threadSlot = -1;
+
+static const char* phaseNames[PROFILE_PHASES] = {
+
+    "stepSimulation",
+    "computeForces",
+    "F_EULER",
+    "B_EULER",
+    "MB_EULER",
+    "FB_EULER",
+    "MFB_EULER",
+    "RK2_EULER",
+    "RK4_EULER",
+    "VERLET",
+    "PROJECTIVE",
+    "XPBD",
+    "MULTIRATE",
+    "fusedStep",
+    "constraintsInverse",
+    "sphereCollision",
+    "planarCollision",
+    "selfCollision",
+    "setWind",
+    "updateVertexNormals",
+    "vboUpload"
+};
+
+Profiler::Profiler(void)
+{
+    for (GLsizei t = 0; t < PROFILE_THREADS; t++)
+        rings[t].store(NULL);
+
+    dropped.store(0);
+    history.resize(PROFILE_PHASES);
+
+    reset();
+}
+
+Profiler::~Profiler(void)
+{
+    for (GLsizei t = 0; t < PROFILE_THREADS; t++)
+        delete rings[t].load();
+}
+
+Profiler::Ring* Profiler::threadRing(void) {
+
+    if (threadSlot < 0)
+        threadSlot = nextThreadSlot.fetch_add(1);
+
+    if (threadSlot >= PROFILE_THREADS)
+        return(NULL);
+
+    Ring* ring = rings[threadSlot].load(std::memory_order_acquire);
+
+    // Only this thread ever installs its slot's ring
+    if (!ring) {
+
+        ring = new Ring();
+        ring->head.store(0);
+        ring->tail.store(0);
+
+        rings[threadSlot].store(ring, std::memory_order_release);
+    }
+
+    return(ring);
+}
+
+GLvoid Profiler::record(ProfilePhase phase, uint64_t nanoseconds) {
+
+    Ring* ring = threadRing();
+
+    if (!ring) {
+
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    GLuint head = ring->head.load(std::memory_order_relaxed);
+
+    if ((head - ring->tail.load(std::memory_order_acquire)) >= PROFILE_RING) {
+
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Sample& sample = ring->samples[head % PROFILE_RING];
+    sample.phase = phase;
+    sample.nanoseconds = nanoseconds;
+
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+GLvoid Profiler::endFrame(void) {
+
+    for (GLsizei t = 0; t < PROFILE_THREADS; t++) {
+
+        Ring* ring = rings[t].load(std::memory_order_acquire);
+
+        if (!ring)
+            continue;
+
+        GLuint tail = ring->tail.load(std::memory_order_relaxed);
+        GLuint head = ring->head.load(std::memory_order_acquire);
+
+        for (; tail != head; tail++) {
+
+            const Sample& sample = ring->samples[tail % PROFILE_RING];
+
+            frameTotals[sample.phase] += sample.nanoseconds * 1.0e-3;
+            frameCalls[sample.phase]++;
+        }
+
+        ring->tail.store(tail, std::memory_order_release);
+    }
+
+    for (GLsizei p = 0; p < PROFILE_PHASES; p++) {
+
+        if (!frameCalls[p])
+            continue;
+
+        History& h = history[p];
+
+        h.totals[h.next] = frameTotals[p];
+        h.calls[h.next] = frameCalls[p];
+
+        h.next = (h.next + 1) % PROFILE_WINDOW;
+        h.count = std::min(h.count + 1, PROFILE_WINDOW);
+
+        frameTotals[p] = 0;
+        frameCalls[p] = 0;
+    }
+}
+
+ProfileStats Profiler::getStats(ProfilePhase phase) const {
+
+    ProfileStats stats;
+    memset(&stats, 0, sizeof(ProfileStats));
+
+    const History& h = history[phase];
+
+    if (!h.count)
+        return(stats);
+
+    std::vector<double> totals(h.totals, h.totals + h.count);
+
+    double sum = 0;
+    GLuint calls = 0;
+
+    for (GLsizei f = 0; f < h.count; f++) {
+
+        sum += h.totals[f];
+        calls += h.calls[f];
+    }
+
+    // Nearest rank percentile
+    GLsizei rank = (GLsizei)std::ceil(0.99 * h.count) - 1;
+    std::nth_element(totals.begin(), totals.begin() + rank, totals.end());
+
+    stats.frames = h.count;
+    stats.calls = (GLfloat)calls / h.count;
+    stats.min = *std::min_element(h.totals, h.totals + h.count);
+    stats.mean = sum / h.count;
+    stats.p99 = totals[rank];
+
+    return(stats);
+}
+
+uint64_t Profiler::getDropped(void) const {
+    return(dropped.load(std::memory_order_relaxed));
+}
+
+// Clears the statistics, samples still buffered are kept for the next frame
+GLvoid Profiler::reset(void) {
+
+    for (GLsizei p = 0; p < PROFILE_PHASES; p++) {
+
+        frameTotals[p] = 0;
+        frameCalls[p] = 0;
+
+        history[p].count = 0;
+        history[p].next = 0;
+    }
+
+    dropped.store(0);
+}
+
+const char* Profiler::getName(ProfilePhase phase) {
+    return(phaseNames[phase]);
+}
@@ -0,0 +1,149 @@
+// Header Guards
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#pragma once
+
+// OpenGL Scalar Types, see GLTypes.hpp
+#include "GLTypes.hpp"
+
+// C/C++ Standard Libraries
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#define PROFILE_THREADS 64  // Threads that may record against one profiler, samples from any further threads are dropped
+#define PROFILE_RING 1024   // Samples buffered per thread between frames, a full ring drops samples
+#define PROFILE_WINDOW 256  // Frames the statistics are taken over
+
+// Scoped phase timers, compiled out unless CLOTH_PROFILING is defined
+#ifdef CLOTH_PROFILING
+#define PROFILE_SCOPE_JOIN(a, b) a##b
+#define PROFILE_SCOPE_NAME(line) PROFILE_SCOPE_JOIN(profileScope, line)
+#define PROFILE_SCOPE(profiler, phase) ProfileScope PROFILE_SCOPE_NAME(__LINE__)((profiler), (phase))
+#else
+#define PROFILE_SCOPE(profiler, phase)
+#endif
+
+// Timed phases, phases are inclusive, e.g. RK4_EULER includes the computeForces calls made by each stage
+enum ProfilePhase {
+
+    PROFILE_STEP,               // stepSimulation as a whole
+    PROFILE_FORCES,             // computeForces
+    PROFILE_F_EULER,
+    PROFILE_B_EULER,
+    PROFILE_MB_EULER,
+    PROFILE_FB_EULER,
+    PROFILE_MFB_EULER,
+    PROFILE_RK2_EULER,
+    PROFILE_RK4_EULER,
+    PROFILE_VERLET,
+    PROFILE_PROJECTIVE,
+    PROFILE_XPBD,
+    PROFILE_MULTIRATE,
+    PROFILE_FUSED,              // Fused force, integration and reset pass, replaces FORCES and the integrator
+    PROFILE_INVERSE,            // constraintsInverse
+    PROFILE_SPHERE_COLLISION,
+    PROFILE_PLANAR_COLLISION,
+    PROFILE_SELF_COLLISION,
+    PROFILE_WIND,
+    PROFILE_NORMALS,            // Vertex normal accumulation
+    PROFILE_UPLOAD,             // Vertex packing and VBO upload in ClothRenderer
+    PROFILE_PHASES
+};
+
+// Statistics over the per frame totals of one phase, frames in which the phase never ran are not counted
+struct ProfileStats {
+
+    GLsizei frames;     // Frames in the window
+    GLfloat calls;      // Mean timed calls per frame
+
+    double min;         // Microseconds per frame
+    double mean;
+    double p99;
+};
+
+// Collects phase timings, each thread writes to its own single producer/single consumer ring without locking
+// and endFrame drains every ring into per frame totals
+class Profiler {
+
+public:
+
+    Profiler(void);
+    ~Profiler(void);
+
+    // Called from any thread, never blocks
+    GLvoid record(ProfilePhase phase, uint64_t nanoseconds);
+
+    // Called from one thread only, closes the frame
+    GLvoid endFrame(void);
+
+    ProfileStats getStats(ProfilePhase phase) const;
+    uint64_t getDropped(void) const;
+
+    GLvoid reset(void);
+
+    static const char* getName(ProfilePhase phase);
+
+private:
+
+    Profiler(const Profiler&);
+    Profiler& operator=(const Profiler&);
+
+    struct Sample {
+
+        GLuint phase;
+        uint64_t nanoseconds;
+    };
+
+    struct Ring {
+
+        Sample samples[PROFILE_RING];
+
+        std::atomic<GLuint> head;   // Written by the recording thread
+        std::atomic<GLuint> tail;   // Written by endFrame
+    };
+
+    // Per frame totals of one phase, the last PROFILE_WINDOW frames it ran in
+    struct History {
+
+        double totals[PROFILE_WINDOW];
+        GLuint calls[PROFILE_WINDOW];
+
+        GLsizei count;
+        GLsizei next;
+    };
+
+    Ring* threadRing(void);
+
+    std::atomic<Ring*> rings[PROFILE_THREADS];
+    std::atomic<uint64_t> dropped;
+
+    double frameTotals[PROFILE_PHASES];
+    GLuint frameCalls[PROFILE_PHASES];
+
+    std::vector<History> history;
+};
+
+class ProfileScope {
+
+public:
+
+    ProfileScope(Profiler& profiler, ProfilePhase phase) : profiler(profiler), phase(phase), start(Clock::now()) {
+    }
+
+    ~ProfileScope(void) {
+        profiler.record(phase, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+    }
+
+private:
+
+    typedef std::chrono::steady_clock Clock;
+
+    Profiler& profiler;
+    ProfilePhase phase;
+    Clock::time_point start;
+};
+
+#endif /* Profiler_hpp */
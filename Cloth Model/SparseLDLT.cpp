@@ -0,0 +1,214 @@
+#include "SparseLDLT.hpp"
+
+// C/C++ Standard Libraries
+#include <cfloat>
+#include <cmath>
+
+using namespace std;
+using namespace glm;
+
+SparseLDLT::SparseLDLT(void)
+{
+    rows = 0;
+}
+
+SparseLDLT::~SparseLDLT(void)
+{
+}
+
+GLboolean SparseLDLT::factor(GLsizei nRows, const vector<GLuint>& rowOffsets, const vector<GLuint>& columns,
+                             const vector<GLfloat>& values, const vector<GLuint>& order) {
+
+    clear();
+
+    const GLsizei n = nRows;
+
+    permutation = order;
+    inversePermutation.resize(n);
+
+    for (GLsizei k = 0; k < n; k++)
+        inversePermutation[permutation[k]] = k;
+
+    // Symbolic, the elimination tree and the entries of each column of L. Row k of L is the union of the tree paths from
+    // the entries of row k of the permuted A up towards k
+    vector<GLuint> count(n);
+    vector<GLint> flag(n);
+
+    parent.resize(n);
+
+    for (GLsizei k = 0; k < n; k++) {
+
+        parent[k] = -1;
+        flag[k] = k;
+        count[k] = 0;
+
+        const GLuint row = permutation[k];
+
+        for (GLuint p = rowOffsets[row]; p < rowOffsets[row + 1]; p++) {
+
+            GLint i = inversePermutation[columns[p]];
+
+            if (i >= k)
+                continue;
+
+            for (; flag[i] != k; i = parent[i]) {
+
+                if (parent[i] == -1)
+                    parent[i] = k;
+
+                count[i]++;
+                flag[i] = k;
+            }
+        }
+    }
+
+    columnOffsets.resize(n + 1);
+    columnOffsets[0] = 0;
+
+    for (GLsizei k = 0; k < n; k++)
+        columnOffsets[k + 1] = columnOffsets[k] + count[k];
+
+    rowIndices.resize(columnOffsets[n]);
+    lower.resize(columnOffsets[n]);
+    diagonal.resize(n);
+
+    // Numeric, row k of L by a sparse triangular solve against the rows above it, the pattern is visited in topological
+    // order of the elimination tree
+    vector<GLfloat> y(n, 0.0f);
+    vector<GLuint> pattern(n);
+
+    const GLfloat flush = std::sqrt(FLT_MIN);
+
+    for (GLsizei k = 0; k < n; k++) {
+
+        GLsizei top = n;
+
+        flag[k] = k;
+        count[k] = 0;
+
+        const GLuint row = permutation[k];
+
+        for (GLuint p = rowOffsets[row]; p < rowOffsets[row + 1]; p++) {
+
+            GLint i = inversePermutation[columns[p]];
+
+            if (i > k)
+                continue;
+
+            y[i] += values[p];
+
+            GLsizei length = 0;
+
+            for (; flag[i] != k; i = parent[i]) {
+
+                pattern[length++] = i;
+                flag[i] = k;
+            }
+
+            while (length > 0)
+                pattern[--top] = pattern[--length];
+        }
+
+        GLfloat d = y[k];
+        y[k] = 0.0f;
+
+        for (; top < n; top++) {
+
+            const GLuint i = pattern[top];
+            const GLfloat yi = y[i];
+            y[i] = 0.0f;
+
+            const GLuint end = columnOffsets[i] + count[i];
+
+            // Fill far from the diagonal decays geometrically, entries below sqrt(FLT_MIN) are flushed to zero so no
+            // product of two entries in the factorisation or the solves is subnormal
+            GLfloat l = 0.0f;
+
+            if (std::fabs(yi) >= flush) {
+
+                for (GLuint p = columnOffsets[i]; p < end; p++)
+                    y[rowIndices[p]] -= lower[p] * yi;
+
+                l = yi / diagonal[i];
+
+                if (std::fabs(l) < flush)
+                    l = 0.0f;
+
+                d -= l * yi;
+            }
+
+            rowIndices[end] = k;
+            lower[end] = l;
+            count[i]++;
+        }
+
+        if (d == 0.0f) {
+
+            clear();
+            return(GL_FALSE);
+        }
+
+        diagonal[k] = d;
+    }
+
+    rows = n;
+    work.resize(n);
+
+    return(GL_TRUE);
+}
+
+GLvoid SparseLDLT::clear(void) {
+
+    rows = 0;
+
+    vector<GLuint>().swap(permutation);
+    vector<GLuint>().swap(inversePermutation);
+    vector<GLint>().swap(parent);
+    vector<GLuint>().swap(columnOffsets);
+    vector<GLuint>().swap(rowIndices);
+    vector<GLfloat>().swap(lower);
+    vector<GLfloat>().swap(diagonal);
+    vector<vec3>().swap(work);
+}
+
+GLsizei SparseLDLT::getRows(void) const {
+    return(rows);
+}
+
+// Strictly lower entries of L
+GLsizei SparseLDLT::getNonZeros(void) const {
+    return(rows ? (GLsizei)columnOffsets[rows] : 0);
+}
+
+GLvoid SparseLDLT::solve(const vec3* b, vec3* x) {
+
+    for (GLsizei k = 0; k < rows; k++)
+        work[k] = b[permutation[k]];
+
+    // L z = P b
+    for (GLsizei j = 0; j < rows; j++) {
+
+        const vec3 zj = work[j];
+
+        for (GLuint p = columnOffsets[j]; p < columnOffsets[j + 1]; p++)
+            work[rowIndices[p]] -= lower[p] * zj;
+    }
+
+    // D w = z
+    for (GLsizei j = 0; j < rows; j++)
+        work[j] /= diagonal[j];
+
+    // L^T P x = w
+    for (GLsizei j = rows - 1; j >= 0; j--) {
+
+        vec3 sum = work[j];
+
+        for (GLuint p = columnOffsets[j]; p < columnOffsets[j + 1]; p++)
+            sum -= lower[p] * work[rowIndices[p]];
+
+        work[j] = sum;
+    }
+
+    for (GLsizei k = 0; k < rows; k++)
+        x[permutation[k]] = work[k];
+}
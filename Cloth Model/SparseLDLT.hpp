@@ -0,0 +1,55 @@
+// Header Guards
+#ifndef SPARSELDLT_HPP
+#define SPARSELDLT_HPP
+
+#pragma once
+
+// OpenGL Scalar Types, see GLTypes.hpp
+#include "GLTypes.hpp"
+
+// OpenGL Mathematics Library
+#include <GLM/glm.hpp>
+
+// C/C++ Standard Libraries
+#include <vector>
+
+// Sparse L D L^T factorisation of a scalar symmetric positive definite matrix, P A P^T = L D L^T
+// Up-looking, row by row over the elimination tree, after Davis [2005], 'Algorithm 849: A concise sparse Cholesky
+// factorization package'. The fill-reducing permutation P is supplied by the caller, the solves then take one right hand
+// side per coordinate, three at once as a vec3
+class SparseLDLT {
+
+public:
+
+    SparseLDLT(void);
+    ~SparseLDLT(void);
+
+    // A given as compressed rows of both triangles, duplicate entries are summed, order[k] is the row eliminated k-th
+    // Returns GL_FALSE on a zero pivot, the factor is then empty
+    GLboolean factor(GLsizei rows, const std::vector<GLuint>& rowOffsets, const std::vector<GLuint>& columns,
+                     const std::vector<GLfloat>& values, const std::vector<GLuint>& order);
+    GLvoid clear(void);
+
+    GLsizei getRows(void) const;
+    GLsizei getNonZeros(void) const;
+
+    // x = A^-1 b, x & b may alias
+    GLvoid solve(const glm::vec3* b, glm::vec3* x);
+
+private:
+
+    GLsizei rows;
+
+    std::vector<GLuint> permutation;        // Row of A eliminated k-th
+    std::vector<GLuint> inversePermutation;
+
+    std::vector<GLint> parent;              // Elimination tree, -1 at the roots
+    std::vector<GLuint> columnOffsets;      // Strictly lower L by columns, per column offsets into rowIndices & lower
+    std::vector<GLuint> rowIndices;
+    std::vector<GLfloat> lower;
+    std::vector<GLfloat> diagonal;          // D
+
+    std::vector<glm::vec3> work;            // Permuted right hand side of a solve
+};
+
+#endif /* SparseLDLT_hpp */
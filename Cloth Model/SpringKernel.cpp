@@ -0,0 +1,314 @@
+#include "SpringKernel.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SPRINGKERNEL_X86
+#include <immintrin.h>
+#endif
+
+using namespace glm;
+
+static_assert(sizeof(vec3) == 3 * sizeof(GLfloat), "The vector kernels address the particle streams as packed float triples");
+
+// F = (-Ks (|x| - r) + Kd (v . x) / |x|) x / |x|, with 1 / |x| taken once per spring and |x| = (x . x) / |x|
+static GLvoid evaluateScalar(const Spring* springs, const SpringMaterial* materials,
+                             const vec3* position, const vec3* velocity,
+                             vec3* springForce, GLsizei first, GLsizei last) {
+
+    for (GLsizei s = first; s < last; s++) {
+
+        const Spring& c = springs[s];
+        const SpringMaterial& mat = materials[c.material];
+
+        vec3 deltaP = position[c.particleA] - position[c.particleB];
+        vec3 deltaV = velocity[c.particleA] - velocity[c.particleB];
+
+        GLfloat sLength2 = dot(deltaP, deltaP);
+        GLfloat invLength = 1.0f / sqrt(sLength2);
+        GLfloat sLength = sLength2 * invLength;
+
+        GLfloat LHS = -(mat.Ks) * (sLength - c.restLength);
+        GLfloat RHS = mat.Kd * dot(deltaV, deltaP) * invLength;
+
+        springForce[s] = ((LHS + RHS) * invLength) * deltaP;
+    }
+}
+
+#ifdef SPRINGKERNEL_X86
+
+// SSE4.2 has no gathers, spring and particle fields are loaded per lane
+__attribute__((target("sse4.2")))
+static GLvoid evaluateSSE42(const Spring* springs, const SpringMaterial* materials,
+                            const vec3* position, const vec3* velocity,
+                            vec3* springForce, GLsizei first, GLsizei last) {
+
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 threeHalves = _mm_set1_ps(1.5f);
+
+    GLsizei s = first;
+
+    for (; s + 4 <= last; s += 4) {
+
+        const Spring* c = &springs[s];
+
+        const vec3 &pA0 = position[c[0].particleA], &pA1 = position[c[1].particleA], &pA2 = position[c[2].particleA], &pA3 = position[c[3].particleA];
+        const vec3 &pB0 = position[c[0].particleB], &pB1 = position[c[1].particleB], &pB2 = position[c[2].particleB], &pB3 = position[c[3].particleB];
+        const vec3 &vA0 = velocity[c[0].particleA], &vA1 = velocity[c[1].particleA], &vA2 = velocity[c[2].particleA], &vA3 = velocity[c[3].particleA];
+        const vec3 &vB0 = velocity[c[0].particleB], &vB1 = velocity[c[1].particleB], &vB2 = velocity[c[2].particleB], &vB3 = velocity[c[3].particleB];
+
+        __m128 dx = _mm_sub_ps(_mm_setr_ps(pA0.x, pA1.x, pA2.x, pA3.x), _mm_setr_ps(pB0.x, pB1.x, pB2.x, pB3.x));
+        __m128 dy = _mm_sub_ps(_mm_setr_ps(pA0.y, pA1.y, pA2.y, pA3.y), _mm_setr_ps(pB0.y, pB1.y, pB2.y, pB3.y));
+        __m128 dz = _mm_sub_ps(_mm_setr_ps(pA0.z, pA1.z, pA2.z, pA3.z), _mm_setr_ps(pB0.z, pB1.z, pB2.z, pB3.z));
+
+        __m128 vx = _mm_sub_ps(_mm_setr_ps(vA0.x, vA1.x, vA2.x, vA3.x), _mm_setr_ps(vB0.x, vB1.x, vB2.x, vB3.x));
+        __m128 vy = _mm_sub_ps(_mm_setr_ps(vA0.y, vA1.y, vA2.y, vA3.y), _mm_setr_ps(vB0.y, vB1.y, vB2.y, vB3.y));
+        __m128 vz = _mm_sub_ps(_mm_setr_ps(vA0.z, vA1.z, vA2.z, vA3.z), _mm_setr_ps(vB0.z, vB1.z, vB2.z, vB3.z));
+
+        __m128 rest = _mm_setr_ps(c[0].restLength, c[1].restLength, c[2].restLength, c[3].restLength);
+        __m128 Ks = _mm_setr_ps(materials[c[0].material].Ks, materials[c[1].material].Ks, materials[c[2].material].Ks, materials[c[3].material].Ks);
+        __m128 Kd = _mm_setr_ps(materials[c[0].material].Kd, materials[c[1].material].Kd, materials[c[2].material].Kd, materials[c[3].material].Kd);
+
+        __m128 sLength2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        __m128 vDotP = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, dx), _mm_mul_ps(vy, dy)), _mm_mul_ps(vz, dz));
+
+        // Reciprocal square root estimate, refined by one Newton-Raphson step
+        __m128 invLength = _mm_rsqrt_ps(sLength2);
+        invLength = _mm_mul_ps(invLength, _mm_sub_ps(threeHalves, _mm_mul_ps(_mm_mul_ps(half, sLength2), _mm_mul_ps(invLength, invLength))));
+
+        __m128 sLength = _mm_mul_ps(sLength2, invLength);
+
+        __m128 LHS = _mm_mul_ps(Ks, _mm_sub_ps(rest, sLength));
+        __m128 RHS = _mm_mul_ps(_mm_mul_ps(Kd, vDotP), invLength);
+        __m128 scale = _mm_mul_ps(_mm_add_ps(LHS, RHS), invLength);
+
+        GLfloat fx[4], fy[4], fz[4];
+
+        _mm_storeu_ps(fx, _mm_mul_ps(scale, dx));
+        _mm_storeu_ps(fy, _mm_mul_ps(scale, dy));
+        _mm_storeu_ps(fz, _mm_mul_ps(scale, dz));
+
+        for (GLsizei k = 0; k < 4; k++)
+            springForce[s + k] = vec3(fx[k], fy[k], fz[k]);
+    }
+
+    evaluateScalar(springs, materials, position, velocity, springForce, s, last);
+}
+
+// Spring records are gathered as 4 words, particle streams as 3 floats and the material table as 4 floats
+__attribute__((target("avx2,fma")))
+static GLvoid evaluateAVX2(const Spring* springs, const SpringMaterial* materials,
+                           const vec3* position, const vec3* velocity,
+                           vec3* springForce, GLsizei first, GLsizei last) {
+
+    const __m256i record = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+    const __m256i three = _mm256_set1_epi32(3);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 threeHalves = _mm256_set1_ps(1.5f);
+
+    const GLfloat* pos = (const GLfloat*)position;
+    const GLfloat* vel = (const GLfloat*)velocity;
+    const GLfloat* mats = (const GLfloat*)materials;
+
+    GLsizei s = first;
+
+    for (; s + 8 <= last; s += 8) {
+
+        const int* c = (const int*)&springs[s];
+
+        __m256i a = _mm256_mullo_epi32(_mm256_i32gather_epi32(c + 0, record, 4), three);
+        __m256i b = _mm256_mullo_epi32(_mm256_i32gather_epi32(c + 1, record, 4), three);
+        __m256 rest = _mm256_i32gather_ps((const float*)(c + 2), record, 4);
+        __m256i m = _mm256_slli_epi32(_mm256_i32gather_epi32(c + 3, record, 4), 2);
+
+        __m256 dx = _mm256_sub_ps(_mm256_i32gather_ps(pos + 0, a, 4), _mm256_i32gather_ps(pos + 0, b, 4));
+        __m256 dy = _mm256_sub_ps(_mm256_i32gather_ps(pos + 1, a, 4), _mm256_i32gather_ps(pos + 1, b, 4));
+        __m256 dz = _mm256_sub_ps(_mm256_i32gather_ps(pos + 2, a, 4), _mm256_i32gather_ps(pos + 2, b, 4));
+
+        __m256 vx = _mm256_sub_ps(_mm256_i32gather_ps(vel + 0, a, 4), _mm256_i32gather_ps(vel + 0, b, 4));
+        __m256 vy = _mm256_sub_ps(_mm256_i32gather_ps(vel + 1, a, 4), _mm256_i32gather_ps(vel + 1, b, 4));
+        __m256 vz = _mm256_sub_ps(_mm256_i32gather_ps(vel + 2, a, 4), _mm256_i32gather_ps(vel + 2, b, 4));
+
+        __m256 Ks = _mm256_i32gather_ps(mats + 0, m, 4);
+        __m256 Kd = _mm256_i32gather_ps(mats + 1, m, 4);
+
+        __m256 sLength2 = _mm256_fmadd_ps(dz, dz, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dx, dx)));
+        __m256 vDotP = _mm256_fmadd_ps(vz, dz, _mm256_fmadd_ps(vy, dy, _mm256_mul_ps(vx, dx)));
+
+        // Reciprocal square root estimate, refined by one Newton-Raphson step
+        __m256 invLength = _mm256_rsqrt_ps(sLength2);
+        invLength = _mm256_mul_ps(invLength, _mm256_fnmadd_ps(_mm256_mul_ps(half, sLength2), _mm256_mul_ps(invLength, invLength), threeHalves));
+
+        __m256 sLength = _mm256_mul_ps(sLength2, invLength);
+
+        __m256 LHS = _mm256_mul_ps(Ks, _mm256_sub_ps(rest, sLength));
+        __m256 scale = _mm256_mul_ps(_mm256_fmadd_ps(_mm256_mul_ps(Kd, vDotP), invLength, LHS), invLength);
+
+        GLfloat fx[8], fy[8], fz[8];
+
+        _mm256_storeu_ps(fx, _mm256_mul_ps(scale, dx));
+        _mm256_storeu_ps(fy, _mm256_mul_ps(scale, dy));
+        _mm256_storeu_ps(fz, _mm256_mul_ps(scale, dz));
+
+        for (GLsizei k = 0; k < 8; k++)
+            springForce[s + k] = vec3(fx[k], fy[k], fz[k]);
+    }
+
+    evaluateScalar(springs, materials, position, velocity, springForce, s, last);
+}
+
+// Masked forms with every lane enabled, here & below, so no result starts from an undefined register
+__attribute__((target("avx512f")))
+static inline __m512 gather512(__m512i index, const GLfloat* base) {
+    return(_mm512_mask_i32gather_ps(_mm512_setzero_ps(), 0xFFFF, index, base, 4));
+}
+
+__attribute__((target("avx512f")))
+static inline __m512i gather512(__m512i index, const int* base) {
+    return(_mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF, index, base, 4));
+}
+
+// As AVX2, with the 16 resultant forces scattered directly into the interleaved output
+__attribute__((target("avx512f")))
+static GLvoid evaluateAVX512(const Spring* springs, const SpringMaterial* materials,
+                             const vec3* position, const vec3* velocity,
+                             vec3* springForce, GLsizei first, GLsizei last) {
+
+    const __m512i record = _mm512_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28, 32, 36, 40, 44, 48, 52, 56, 60);
+    const __m512i output = _mm512_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21, 24, 27, 30, 33, 36, 39, 42, 45);
+    const __m512i three = _mm512_set1_epi32(3);
+    const __m512 half = _mm512_set1_ps(0.5f);
+    const __m512 threeHalves = _mm512_set1_ps(1.5f);
+
+    const GLfloat* pos = (const GLfloat*)position;
+    const GLfloat* vel = (const GLfloat*)velocity;
+    const GLfloat* mats = (const GLfloat*)materials;
+
+    GLsizei s = first;
+
+    for (; s + 16 <= last; s += 16) {
+
+        const int* c = (const int*)&springs[s];
+
+        __m512i a = _mm512_mullo_epi32(gather512(record, c + 0), three);
+        __m512i b = _mm512_mullo_epi32(gather512(record, c + 1), three);
+        __m512 rest = gather512(record, (const float*)(c + 2));
+        __m512i m = _mm512_maskz_slli_epi32(0xFFFF, gather512(record, c + 3), 2);
+
+        __m512 dx = _mm512_sub_ps(gather512(a, pos + 0), gather512(b, pos + 0));
+        __m512 dy = _mm512_sub_ps(gather512(a, pos + 1), gather512(b, pos + 1));
+        __m512 dz = _mm512_sub_ps(gather512(a, pos + 2), gather512(b, pos + 2));
+
+        __m512 vx = _mm512_sub_ps(gather512(a, vel + 0), gather512(b, vel + 0));
+        __m512 vy = _mm512_sub_ps(gather512(a, vel + 1), gather512(b, vel + 1));
+        __m512 vz = _mm512_sub_ps(gather512(a, vel + 2), gather512(b, vel + 2));
+
+        __m512 Ks = gather512(m, mats + 0);
+        __m512 Kd = gather512(m, mats + 1);
+
+        __m512 sLength2 = _mm512_fmadd_ps(dz, dz, _mm512_fmadd_ps(dy, dy, _mm512_mul_ps(dx, dx)));
+        __m512 vDotP = _mm512_fmadd_ps(vz, dz, _mm512_fmadd_ps(vy, dy, _mm512_mul_ps(vx, dx)));
+
+        // 14 bit reciprocal square root estimate, refined by one Newton-Raphson step
+        __m512 invLength = _mm512_maskz_rsqrt14_ps(0xFFFF, sLength2);
+        invLength = _mm512_mul_ps(invLength, _mm512_fnmadd_ps(_mm512_mul_ps(half, sLength2), _mm512_mul_ps(invLength, invLength), threeHalves));
+
+        __m512 sLength = _mm512_mul_ps(sLength2, invLength);
+
+        __m512 LHS = _mm512_mul_ps(Ks, _mm512_sub_ps(rest, sLength));
+        __m512 scale = _mm512_mul_ps(_mm512_fmadd_ps(_mm512_mul_ps(Kd, vDotP), invLength, LHS), invLength);
+
+        GLfloat* out = (GLfloat*)&springForce[s];
+
+        _mm512_i32scatter_ps(out + 0, output, _mm512_mul_ps(scale, dx), 4);
+        _mm512_i32scatter_ps(out + 1, output, _mm512_mul_ps(scale, dy), 4);
+        _mm512_i32scatter_ps(out + 2, output, _mm512_mul_ps(scale, dz), 4);
+    }
+
+    evaluateScalar(springs, materials, position, velocity, springForce, s, last);
+}
+
+#endif
+
+SpringKernel::SpringKernel(void)
+{
+    setISA(AVX512);
+}
+
+SpringKernel::~SpringKernel(void)
+{
+}
+
+GLvoid SpringKernel::setISA(ISA request) {
+
+    ISA supported = supportedISA();
+
+    isa = (request < supported) ? request : supported;
+
+    switch (isa) {
+
+#ifdef SPRINGKERNEL_X86
+        case AVX512:
+            kernel = evaluateAVX512;
+            break;
+
+        case AVX2:
+            kernel = evaluateAVX2;
+            break;
+
+        case SSE42:
+            kernel = evaluateSSE42;
+            break;
+#endif
+
+        default:
+            isa = SCALAR;
+            kernel = evaluateScalar;
+            break;
+    }
+}
+
+SpringKernel::ISA SpringKernel::getISA(void) const {
+    return(isa);
+}
+
+SpringKernel::ISA SpringKernel::supportedISA(void) {
+
+#ifdef SPRINGKERNEL_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f"))
+        return(AVX512);
+
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return(AVX2);
+
+    if (__builtin_cpu_supports("sse4.2"))
+        return(SSE42);
+#endif
+
+    return(SCALAR);
+}
+
+const char* SpringKernel::getName(ISA isa) {
+
+    switch (isa) {
+
+        case SSE42:
+            return("SSE4.2");
+
+        case AVX2:
+            return("AVX2");
+
+        case AVX512:
+            return("AVX-512");
+
+        default:
+            return("Scalar");
+    }
+}
+
+GLvoid SpringKernel::evaluate(const Spring* springs, const SpringMaterial* materials,
+                              const vec3* position, const vec3* velocity,
+                              vec3* springForce, GLsizei first, GLsizei last) const {
+
+    kernel(springs, materials, position, velocity, springForce, first, last);
+}
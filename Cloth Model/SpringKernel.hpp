@@ -0,0 +1,72 @@
+// Header Guards
+#ifndef SPRINGKERNEL_HPP
+#define SPRINGKERNEL_HPP
+
+#pragma once
+
+// OpenGL Scalar Types, see GLTypes.hpp
+#include "GLTypes.hpp"
+
+// OpenGL Mathematics Library
+#include <GLM/glm.hpp>
+
+#define SPRING_BLOCK 1024 // Springs per kernel call, the unit of work handed to each thread
+
+// Per spring type constants, shared by every spring of that type
+struct SpringMaterial {
+
+    GLfloat Ks, Kd;     // Mass-Spring vars, Stiffness & Damping constants
+    GLfloat K, Kp;      // Position Dynamic vars, ...
+};
+
+// Compact 16 byte spring record, indexes into the particle streams and the material table
+struct Spring {
+
+    GLuint particleA;
+    GLuint particleB;
+
+    GLfloat restLength;
+
+    GLuint material;    // Spring type, STRUCTURAL_SPRING, SHEAR_SPRING or BEND_SPRING
+};
+
+static_assert(sizeof(Spring) == 16, "Spring should remain a compact 16 byte record, the vector kernels gather from it");
+
+// Vectorised damped spring force evaluation, selected at runtime from the instruction sets the CPU supports
+// Each spring shares a single reciprocal square root between its length and direction
+class SpringKernel {
+
+public:
+
+    enum ISA {
+
+        SCALAR,
+        SSE42,      // 4 springs per iteration
+        AVX2,       // 8 springs per iteration
+        AVX512      // 16 springs per iteration
+    };
+
+    SpringKernel(void);
+    ~SpringKernel(void);
+
+    // Requests an instruction set, falling back to the best supported one below it
+    GLvoid setISA(ISA isa);
+    ISA getISA(void) const;
+
+    static ISA supportedISA(void);
+    static const char* getName(ISA isa);
+
+    // Resultant force on the first particle of each spring in [first, last), written to springForce[s]
+    GLvoid evaluate(const Spring* springs, const SpringMaterial* materials,
+                    const glm::vec3* position, const glm::vec3* velocity,
+                    glm::vec3* springForce, GLsizei first, GLsizei last) const;
+
+private:
+
+    typedef GLvoid (*KernelFunc)(const Spring*, const SpringMaterial*, const glm::vec3*, const glm::vec3*, glm::vec3*, GLsizei, GLsizei);
+
+    ISA isa;
+    KernelFunc kernel;
+};
+
+#endif /* SpringKernel_hpp */
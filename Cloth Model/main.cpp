@@ -33,6 +33,7 @@
 // Internal Dependancies
 #include "Shader.hpp"
 #include "Cloth.hpp"
+#include "ClothRenderer.hpp"
 #include "ObjectMesh.hpp"
 #include "TrackBall.hpp"
 
@@ -79,6 +80,7 @@ struct Material {
 Shader* mainShader;
 Shader* subShader;
 Cloth* clothObject;
+ClothRenderer* clothRenderer;
 ObjectMesh* sphereObject;
 ObjectMesh* plane;
 
@@ -101,6 +103,9 @@ static GLuint NxN = 50;
 static GLuint NO_PARTICLES_X = NxN, NO_PARICLES_Y = NxN, Nc = NO_PARTICLES_X * NO_PARICLES_Y;
 
 static GLfloat timestep = 0.0100f;
+static GLboolean adaptiveStep = GL_FALSE;
+static GLint stepsPerFrame = 1;
+static GLint stretchRate = 4, shearRate = 4, bendRate = 1;
 
 static Cloth::IntegrationMethod integration = Cloth::MFB_EULER;
 static Cloth::Preset preset = Cloth::One;
@@ -154,7 +159,10 @@ static TwEnumVal integrationEV[] = {
     { Cloth::FB_EULER,  "FB Symplectic Euler" },
     { Cloth::MFB_EULER, "FB IMplicit-EXplicit" },
     { Cloth::B_EULER,   "FB Backward Euler" },
-    { Cloth::VERLET,    "PB Verlet"}
+    { Cloth::VERLET,    "PB Verlet"},
+    { Cloth::PROJECTIVE, "PB Projective Dynamics" },
+    { Cloth::XPBD,      "PB Extended Position Based" },
+    { Cloth::MULTIRATE, "FB Multi-Rate Symplectic Euler" }
 };
 
 static TwEnumVal presetEV[] = {
@@ -248,7 +256,7 @@ GLvoid initATB(void) {
     TwDefine(" 'Cloth Parameters' refresh = '0.0001f' ");
     TwDefine(" 'Cloth Parameters' alpha = '192' ");
     
-    TwType integrationType = TwDefineEnum("Integration Mode", integrationEV, 7);
+    TwType integrationType = TwDefineEnum("Integration Mode", integrationEV, 10);
     TwType presetType = TwDefineEnum("Preset", presetEV, 2);
 
     // 'Cloth Parameters' Bar Variable Tweak Initialisations
@@ -261,6 +269,13 @@ GLvoid initATB(void) {
     
     TwAddVarRW(tMain, "Timestep", TW_TYPE_FLOAT, &timestep, "group = 'Integration' min = 0.00001 max = 0.7000 step = 0.00085 help = 'Simulation step size'");
     TwAddVarRW(tMain, "Scheme", integrationType, &integration, "group = 'Integration'");
+    TwAddVarRW(tMain, "Adaptive", TW_TYPE_BOOLCPP, &adaptiveStep, "group = 'Integration' help = 'Split each frame of Timestep into steps sized by the scheme'");
+    TwAddVarRO(tMain, "Steps/Frame", TW_TYPE_INT32, &stepsPerFrame, "group = 'Integration'");
+    
+    TwAddVarRW(tMain, "Stretch Rate", TW_TYPE_INT32, &stretchRate, "group = 'Multi-Rate' min = 1 max = 16 help = 'Stretch spring evaluations per step' label = 'Stretch'");
+    TwAddVarRW(tMain, "Shear Rate", TW_TYPE_INT32, &shearRate, "group = 'Multi-Rate' min = 1 max = 16 help = 'Shear spring evaluations per step' label = 'Shear'");
+    TwAddVarRW(tMain, "Bend Rate", TW_TYPE_INT32, &bendRate, "group = 'Multi-Rate' min = 1 max = 16 help = 'Bend spring evaluations per step' label = 'Bend'");
+    TwDefine(" 'Cloth Parameters'/'Multi-Rate' group = 'Integration' ");
     TwAddButton(tMain, "Pause/Play", Pause, NULL, "group = 'Integration'");
     
     TwAddVarRW(tMain, "Global Damping", TW_TYPE_FLOAT, &globalDamping,  "group = 'Constraints' min = -1.000 max = 0.000, step = 0.005 help = 'Particle velocity damping'");
@@ -375,6 +390,15 @@ GLvoid setClothParameters(Cloth* cloth) {
     
     cloth->setStiffness(stretchStiffness, shearStiffness, bendStiffness);
     cloth->setDamping(stretchDamping, shearDamping, shearDamping, globalDamping);
+    cloth->setSpringRates(stretchRate, shearRate, bendRate);
+    
+    Cloth::StepPolicy stepping = cloth->getStepPolicy();
+    
+    if (stepping.adaptive != adaptiveStep) {
+        
+        stepping.adaptive = adaptiveStep;
+        cloth->setStepPolicy(stepping);
+    }
     
     if (sphereCol)
         cloth->sphereCollision(sphereObject->getSpherePosition(), sphereObject->getSphereRadius());
@@ -385,7 +409,7 @@ GLvoid setClothParameters(Cloth* cloth) {
     if (selfCol)
         cloth->selfCollision();
     
-    cloth->setWire(drawW);
+    clothRenderer->setWire(drawW);
     
     if (clothReInit) {
         
@@ -470,6 +494,7 @@ GLint main(GLint argc, const GLchar* argv[]) {
     sphereObject->initSphere(SPHERE_DIMENSIONS, vec3(0, (GLfloat)UNIT_HEIGHT / 2.5f, 0));
     
     clothObject = new Cloth(UNIT_WIDTH, UNIT_HEIGHT, NO_PARTICLES_X, NO_PARICLES_Y, preset);
+    clothRenderer = new ClothRenderer();
     
     glfwSetKeyCallback(gWindow, keyCallback);
     
@@ -522,12 +547,12 @@ GLint main(GLint argc, const GLchar* argv[]) {
         setClothParameters(clothObject);
         
         if (!pausePlay)
-            clothObject->stepSimulation(timestep, integration, inverseDy);
+            stepsPerFrame = clothObject->advanceFrame(timestep, integration, inverseDy);
         
         if (drawCloth) {
             
-            clothObject->render(mainShader);
-            //clothObject->render(subShader);
+            clothRenderer->render(clothObject, mainShader);
+            //clothRenderer->render(clothObject, subShader);
         }
 
         if (drawPlane)
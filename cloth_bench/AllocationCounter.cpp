@@ -0,0 +1,70 @@
+#include "AllocationCounter.hpp"
+
+// C/C++ Standard Libraries
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// POSIX
+#include <dlfcn.h>
+
+static std::atomic<uint64_t> allocations(0);
+static std::atomic<uint64_t> bytes(0);
+
+static void* countedAllocate(std::size_t size) {
+
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    bytes.fetch_add(size, std::memory_order_relaxed);
+
+    void* ptr = std::malloc(size ? size : 1);
+
+    if (!ptr)
+        throw std::bad_alloc();
+
+    return(ptr);
+}
+
+AllocationCounter::Snapshot AllocationCounter::snapshot(void) {
+
+    Snapshot s = { allocations.load(std::memory_order_relaxed), bytes.load(std::memory_order_relaxed) };
+
+    return(s);
+}
+
+void* operator new(std::size_t size) {
+    return(countedAllocate(size));
+}
+
+void* operator new[](std::size_t size) {
+    return(countedAllocate(size));
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+// Aligned streams, see AlignedAllocator in ParticleStore.hpp, are counted by interposing posix_memalign, the allocation
+// itself is forwarded to the next definition, the C library's
+typedef int (*PosixMemalign)(void**, std::size_t, std::size_t);
+
+extern "C" int posix_memalign(void** ptr, std::size_t alignment, std::size_t size) {
+
+    static PosixMemalign next = (PosixMemalign)dlsym(RTLD_NEXT, "posix_memalign");
+
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    bytes.fetch_add(size, std::memory_order_relaxed);
+
+    return(next(ptr, alignment, size));
+}
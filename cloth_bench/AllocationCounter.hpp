@@ -0,0 +1,24 @@
+// Header Guards
+#ifndef ALLOCATIONCOUNTER_HPP
+#define ALLOCATIONCOUNTER_HPP
+
+#pragma once
+
+// C/C++ Standard Libraries
+#include <cstddef>
+#include <cstdint>
+
+// Counts every global operator new made by the process, the benchmark replaces the global allocation functions
+// Aligned streams are allocated with posix_memalign, which the benchmark interposes & counts as well
+namespace AllocationCounter {
+
+    struct Snapshot {
+
+        uint64_t allocations;
+        uint64_t bytes;
+    };
+
+    Snapshot snapshot(void);
+}
+
+#endif /* AllocationCounter_hpp */
@@ -0,0 +1,98 @@
+// Header Guards
+#ifndef CACHEMODEL_HPP
+#define CACHEMODEL_HPP
+
+#pragma once
+
+// C/C++ Standard Libraries
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Set-associative, least recently used cache model, replays an address trace and counts line misses
+class CacheModel {
+
+public:
+
+    CacheModel(std::size_t capacity, std::size_t ways, std::size_t lineSize) : ways(ways), lineSize(lineSize), sets(capacity / (ways * lineSize)), clock(0), hits(0), misses(0)
+    {
+        tags.assign(sets * ways, ~uint64_t(0));
+        ages.assign(sets * ways, 0);
+    }
+
+    // Returns true on a hit, a miss replaces the least recently used line of the set
+    bool access(uint64_t address) {
+
+        uint64_t line = address / lineSize;
+        std::size_t set = (std::size_t)(line % sets);
+
+        uint64_t* tag = &tags[set * ways];
+        uint64_t* age = &ages[set * ways];
+
+        std::size_t victim = 0;
+
+        clock++;
+
+        for (std::size_t w = 0; w < ways; w++) {
+
+            if (tag[w] == line) {
+
+                age[w] = clock;
+                hits++;
+                return(true);
+            }
+
+            if (age[w] < age[victim])
+                victim = w;
+        }
+
+        tag[victim] = line;
+        age[victim] = clock;
+        misses++;
+
+        return(false);
+    }
+
+    uint64_t getHits(void) const {
+        return(hits);
+    }
+
+    uint64_t getMisses(void) const {
+        return(misses);
+    }
+
+private:
+
+    std::size_t ways, lineSize, sets;
+    uint64_t clock, hits, misses;
+
+    std::vector<uint64_t> tags;
+    std::vector<uint64_t> ages;
+};
+
+// Two level hierarchy, the second level only sees the first level's misses
+class CacheHierarchy {
+
+public:
+
+    CacheHierarchy(void) : L1(32 * 1024, 8, 64), L2(1024 * 1024, 16, 64)
+    {
+    }
+
+    template<class T>
+    void access(const T* ptr) {
+
+        uint64_t address = (uint64_t)(uintptr_t)ptr;
+
+        // Accesses straddling a line boundary touch both lines
+        for (uint64_t line = address / 64; line <= (address + sizeof(T) - 1) / 64; line++) {
+
+            if (!L1.access(line * 64))
+                L2.access(line * 64);
+        }
+    }
+
+    CacheModel L1, L2;
+};
+
+#endif /* CacheModel_hpp */
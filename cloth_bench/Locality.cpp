@@ -0,0 +1,107 @@
+#include "Locality.hpp"
+
+using namespace glm;
+
+static const char* orderingName(Cloth::ParticleOrdering ordering) {
+
+    switch (ordering) {
+
+        case Cloth::TILED:
+            return("Tiled");
+
+        case Cloth::MORTON:
+            return("Morton");
+
+        default:
+            return("Row-Major");
+    }
+}
+
+GLvoid runLocality(GLuint size, GLsizei steps) {
+
+    const Cloth::ParticleOrdering orderings[] = { Cloth::ROW_MAJOR, Cloth::TILED, Cloth::MORTON };
+
+    printf("%ux%u cloth, %d timed steps\n\n", size, size, steps);
+    printf("%-10s %14s %14s %14s %14s %12s\n", "Ordering", "L1 Misses", "L1 Miss Rate", "L2 Misses", "L2 Miss Rate", "ms/step");
+
+    for (GLsizei o = 0; o < 3; o++) {
+
+        Cloth cloth(1.0f, 1.0f, size, size, Cloth::One);
+        cloth.setStiffness(KSST, KSSH, KSBE);
+        cloth.setDamping(KDST, KDSH, KDSH, GD);
+        cloth.setParticleOrdering(orderings[o]);
+
+        const ParticleStore& particles = cloth.getParticles();
+        const std::vector<Spring>& constraints = cloth.getConstraints();
+
+        const GLsizei NumP = particles.size();
+        const GLsizei NumC = (GLsizei)constraints.size();
+
+        AlignedVector<vec3> springForce(NumC);
+
+        // Per particle spring lists, as built for the gathered force accumulation
+        std::vector<GLuint> offsets(NumP + 1, 0);
+        std::vector<GLuint> adjacency(NumC * 2);
+
+        for (GLsizei s = 0; s < NumC; s++) {
+            offsets[constraints[s].particleA + 1]++;
+            offsets[constraints[s].particleB + 1]++;
+        }
+
+        for (GLsizei i = 0; i < NumP; i++)
+            offsets[i + 1] += offsets[i];
+
+        std::vector<GLuint> fill(offsets.begin(), offsets.end() - 1);
+
+        for (GLsizei s = 0; s < NumC; s++) {
+            adjacency[fill[constraints[s].particleA]++] = s;
+            adjacency[fill[constraints[s].particleB]++] = s;
+        }
+
+        CacheHierarchy cache;
+
+        // Spring pass, each spring reads both endpoints' position and velocity and writes its resultant force
+        for (GLsizei s = 0; s < NumC; s++) {
+
+            const Spring& c = constraints[s];
+
+            cache.access(&c);
+            cache.access(&particles.position[c.particleA]);
+            cache.access(&particles.position[c.particleB]);
+            cache.access(&particles.velocity[c.particleA]);
+            cache.access(&particles.velocity[c.particleB]);
+            cache.access(&springForce[s]);
+        }
+
+        // Gather pass, each particle sums the forces of its springs
+        for (GLsizei i = 0; i < NumP; i++) {
+
+            cache.access(&offsets[i]);
+
+            for (GLuint k = offsets[i]; k < offsets[i + 1]; k++) {
+
+                cache.access(&adjacency[k]);
+                cache.access(&springForce[adjacency[k]]);
+            }
+
+            cache.access(&particles.force[i]);
+        }
+
+        uint64_t L1Accesses = cache.L1.getHits() + cache.L1.getMisses();
+        uint64_t L2Accesses = cache.L2.getHits() + cache.L2.getMisses();
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (GLsizei step = 0; step < steps; step++)
+            cloth.stepSimulation(0.01f, Cloth::F_EULER, GL_FALSE);
+
+        auto end = std::chrono::high_resolution_clock::now();
+
+        double ms = std::chrono::duration<double, std::milli>(end - start).count() / glm::max(steps, 1);
+
+        printf("%-10s %14llu %13.2f%% %14llu %13.2f%% %12.3f\n", orderingName(orderings[o]),
+               (unsigned long long)cache.L1.getMisses(), (100.0 * cache.L1.getMisses()) / glm::max(L1Accesses, (uint64_t)1),
+               (unsigned long long)cache.L2.getMisses(), (100.0 * cache.L2.getMisses()) / glm::max(L2Accesses, (uint64_t)1),
+               ms);
+    }
+}
@@ -0,0 +1,23 @@
+// Header Guards
+#ifndef LOCALITY_HPP
+#define LOCALITY_HPP
+
+#pragma once
+
+// OpenGL Mathematics Library
+#include <GLM/glm.hpp>
+
+// C/C++ Libraries
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+// Internal Dependancies
+#include "Cloth.hpp"
+#include "CacheModel.hpp"
+
+// Particle ordering locality, replays the memory traffic of the spring force pass and the per particle gather through a
+// simulated 32KiB 8-way L1 and 1MiB 16-way L2, then times explicit steps for each ordering
+GLvoid runLocality(GLuint size, GLsizei steps);
+
+#endif /* Locality_hpp */
@@ -0,0 +1,442 @@
+/// CLOTH BENCHMARKS
+
+/// Sweeps every integration method across cloth sizes and feature sets, reporting ns/particle/step, steps/s, peak RSS
+/// and allocation counts as JSON on stdout, progress is written to stderr
+/// Each case runs in its own child process, so its peak RSS is not inflated by the cases before it
+/// Usage: cloth_bench [-sizes 16,32,...] [-methods F_EULER,...] [-features plain,inverse,...] [-t timestep]
+///                    [-min-time seconds] [-min-steps n] [-max-steps n] [-self-max size]
+///        cloth_bench -locality [grid size, default 1024] [timed steps, default 10]
+
+// OpenGL Mathematics Library
+#include <GLM/glm.hpp>
+
+// C/C++ Libraries
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// POSIX
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Internal Dependancies
+#include "Cloth.hpp"
+#include "AllocationCounter.hpp"
+#include "Locality.hpp"
+
+using namespace glm;
+
+struct MethodName {
+
+    Cloth::IntegrationMethod method;
+    const char* name;
+};
+
+static const MethodName methodNames[] = {
+
+    { Cloth::F_EULER,   "F_EULER" },
+    { Cloth::B_EULER,   "B_EULER" },
+    { Cloth::MB_EULER,  "MB_EULER" },
+    { Cloth::FB_EULER,  "FB_EULER" },
+    { Cloth::MFB_EULER, "MFB_EULER" },
+    { Cloth::RK2_EULER, "RK2_EULER" },
+    { Cloth::RK4_EULER, "RK4_EULER" },
+    { Cloth::VERLET,    "VERLET" },
+    { Cloth::PROJECTIVE, "PROJECTIVE" },
+    { Cloth::XPBD,      "XPBD" },
+    { Cloth::MULTIRATE, "MULTIRATE" }
+};
+
+// Feature set applied every frame, in the same order as the interactive application
+struct Feature {
+
+    const char* name;
+
+    GLboolean inverseDy;
+    GLboolean wind;
+    GLboolean sphereCol;
+    GLboolean planarCol;
+    GLboolean selfCol;
+};
+
+static const Feature features[] = {
+
+    { "plain",   GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE },
+    { "inverse", GL_TRUE,  GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE },
+    { "wind",    GL_TRUE,  GL_TRUE,  GL_FALSE, GL_FALSE, GL_FALSE },
+    { "sphere",  GL_TRUE,  GL_FALSE, GL_TRUE,  GL_FALSE, GL_FALSE },
+    { "planar",  GL_TRUE,  GL_FALSE, GL_FALSE, GL_TRUE,  GL_FALSE },
+    { "self",    GL_TRUE,  GL_FALSE, GL_FALSE, GL_FALSE, GL_TRUE },
+    { "full",    GL_TRUE,  GL_TRUE,  GL_TRUE,  GL_TRUE,  GL_TRUE }
+};
+
+static const GLsizei NumMethods = sizeof(methodNames) / sizeof(methodNames[0]);
+static const GLsizei NumFeatures = sizeof(features) / sizeof(features[0]);
+
+struct Settings {
+
+    GLfloat timestep;
+    double minTime;     // Seconds each case is timed for, at least minSteps and at most maxSteps
+    GLsizei minSteps;
+    GLsizei maxSteps;
+    GLuint selfMax;     // Self collision is O(n^2) in the particle count, larger grids are skipped
+};
+
+// Written by the child process to its parent
+struct Result {
+
+    GLboolean ok;
+    GLboolean stable;   // Every particle position is finite after the timed steps
+
+    GLsizei steps;
+    double seconds;
+    double setupMs;
+
+    uint64_t setupAllocations;
+    uint64_t stepAllocations;
+    uint64_t stepBytes;
+
+    long peakRSS;       // KiB
+};
+
+static long peakRSS(void) {
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+#ifdef __APPLE__
+    return(usage.ru_maxrss / 1024); // Reported in bytes
+#else
+    return(usage.ru_maxrss);        // Reported in KiB
+#endif
+}
+
+static Result runCase(GLuint size, Cloth::IntegrationMethod method, const Feature& feature, const Settings& settings) {
+
+    typedef std::chrono::high_resolution_clock Clock;
+
+    // Scene matching the interactive application defaults
+    const vec3 windDirection = vec3(-0.91f, -0.17f, 0.38f) * 3.6f;
+    const vec3 sphereCentre = vec3(0, 1.0f / 2.5f, 0);
+    const GLfloat sphereRadius = 0.20f;
+
+    Result result;
+    memset(&result, 0, sizeof(Result));
+
+    AllocationCounter::Snapshot before = AllocationCounter::snapshot();
+    Clock::time_point start = Clock::now();
+
+    Cloth cloth(1.0f, 1.0f, size, size, Cloth::One);
+
+    result.setupMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    result.setupAllocations = AllocationCounter::snapshot().allocations - before.allocations;
+
+    GLsizei steps = 0;
+    double seconds = 0;
+
+    // The first step grows any per step scratch storage and is not timed
+    for (GLsizei warm = -1; (warm < 0) || ((steps < settings.maxSteps) && ((steps < settings.minSteps) || (seconds < settings.minTime))); warm++) {
+
+        if (warm == 0)
+            before = AllocationCounter::snapshot();
+
+        start = Clock::now();
+
+        cloth.setStiffness(KSST, KSSH, KSBE);
+        cloth.setDamping(KDST, KDSH, KDSH, GD);
+
+        if (feature.sphereCol)
+            cloth.sphereCollision(sphereCentre, sphereRadius);
+
+        if (feature.planarCol)
+            cloth.planarCollision(0);
+
+        if (feature.selfCol)
+            cloth.selfCollision();
+
+        if (feature.wind)
+            cloth.setWind(windDirection, vec3(0));
+
+        cloth.stepSimulation(settings.timestep, method, feature.inverseDy);
+
+        if (warm >= 0) {
+
+            seconds += std::chrono::duration<double>(Clock::now() - start).count();
+            steps++;
+        }
+    }
+
+    AllocationCounter::Snapshot after = AllocationCounter::snapshot();
+
+    const ParticleStore& particles = cloth.getParticles();
+
+    result.stable = GL_TRUE;
+
+    for (GLsizei i = 0; i < particles.size(); i++) {
+
+        const vec3& p = particles.position[i];
+
+        if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z))
+            result.stable = GL_FALSE;
+    }
+
+    result.ok = GL_TRUE;
+    result.steps = steps;
+    result.seconds = seconds;
+    result.stepAllocations = after.allocations - before.allocations;
+    result.stepBytes = after.bytes - before.bytes;
+    result.peakRSS = peakRSS();
+
+    return(result);
+}
+
+// Runs a case in a child process, a failed or crashed case is reported rather than ending the sweep
+static Result isolateCase(GLuint size, Cloth::IntegrationMethod method, const Feature& feature, const Settings& settings) {
+
+    Result result;
+    memset(&result, 0, sizeof(Result));
+
+    GLint channel[2];
+
+    if (pipe(channel) != 0)
+        return(result);
+
+    fflush(stdout);
+    fflush(stderr);
+
+    pid_t pid = fork();
+
+    if (pid == 0) {
+
+        close(channel[0]);
+
+        Result child = runCase(size, method, feature, settings);
+        ssize_t written = write(channel[1], &child, sizeof(Result));
+
+        close(channel[1]);
+        _exit(written == (ssize_t)sizeof(Result) ? 0 : 1);
+    }
+
+    close(channel[1]);
+
+    if (pid > 0) {
+
+        if (read(channel[0], &result, sizeof(Result)) != (ssize_t)sizeof(Result))
+            result.ok = GL_FALSE;
+
+        waitpid(pid, NULL, 0);
+    }
+
+    close(channel[0]);
+
+    return(result);
+}
+
+static std::vector<std::string> split(const char* list) {
+
+    std::vector<std::string> items;
+    std::string item;
+
+    for (const char* c = list; ; c++) {
+
+        if ((*c == ',') || (*c == '\0')) {
+
+            if (!item.empty())
+                items.push_back(item);
+
+            item.clear();
+
+            if (*c == '\0')
+                break;
+        }
+        else
+            item += *c;
+    }
+
+    return(items);
+}
+
+static GLvoid usage(const char* program) {
+
+    fprintf(stderr, "Usage: %s [-sizes 16,32,...] [-methods F_EULER,...] [-features plain,inverse,...] [-t timestep]\n", program);
+    fprintf(stderr, "       [-min-time seconds] [-min-steps n] [-max-steps n] [-self-max size]\n");
+    fprintf(stderr, "       %s -locality [grid size] [timed steps]\n", program);
+
+    fprintf(stderr, "Methods:");
+
+    for (GLsizei k = 0; k < NumMethods; k++)
+        fprintf(stderr, " %s", methodNames[k].name);
+
+    fprintf(stderr, "\nFeatures:");
+
+    for (GLsizei k = 0; k < NumFeatures; k++)
+        fprintf(stderr, " %s", features[k].name);
+
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char** argv) {
+
+    if ((argc > 1) && !strcmp(argv[1], "-locality")) {
+
+        GLuint size = (argc > 2) ? (GLuint)atoi(argv[2]) : 1024;
+        GLsizei steps = (argc > 3) ? atoi(argv[3]) : 10;
+
+        runLocality(size, steps);
+
+        return(0);
+    }
+
+    Settings settings;
+    settings.timestep = 0.0100f;
+    settings.minTime = 0.25;
+    settings.minSteps = 3;
+    settings.maxSteps = 1000;
+    settings.selfMax = 64;
+
+    std::vector<GLuint> sizes;
+    std::vector<GLsizei> methods;
+    std::vector<GLsizei> featureSet;
+
+    for (GLuint size = 16; size <= 2048; size *= 2)
+        sizes.push_back(size);
+
+    for (GLsizei k = 0; k < NumMethods; k++)
+        methods.push_back(k);
+
+    for (GLsizei k = 0; k < NumFeatures; k++)
+        featureSet.push_back(k);
+
+    for (GLint a = 1; a < argc; a++) {
+
+        if (!strcmp(argv[a], "-sizes") && (a + 1 < argc)) {
+
+            std::vector<std::string> items = split(argv[++a]);
+            sizes.clear();
+
+            for (size_t k = 0; k < items.size(); k++)
+                sizes.push_back((GLuint)atoi(items[k].c_str()));
+        }
+        else if ((!strcmp(argv[a], "-methods") || !strcmp(argv[a], "-features")) && (a + 1 < argc)) {
+
+            GLboolean isMethod = !strcmp(argv[a], "-methods");
+            std::vector<std::string> items = split(argv[++a]);
+            std::vector<GLsizei>& selected = isMethod ? methods : featureSet;
+
+            selected.clear();
+
+            for (size_t k = 0; k < items.size(); k++) {
+
+                GLsizei count = isMethod ? NumMethods : NumFeatures;
+                GLsizei found = 0;
+
+                while ((found < count) && (items[k] != (isMethod ? methodNames[found].name : features[found].name)))
+                    found++;
+
+                if (found == count) {
+
+                    usage(argv[0]);
+                    return(1);
+                }
+
+                selected.push_back(found);
+            }
+        }
+        else if (!strcmp(argv[a], "-t") && (a + 1 < argc))
+            settings.timestep = (GLfloat)atof(argv[++a]);
+        else if (!strcmp(argv[a], "-min-time") && (a + 1 < argc))
+            settings.minTime = atof(argv[++a]);
+        else if (!strcmp(argv[a], "-min-steps") && (a + 1 < argc))
+            settings.minSteps = atoi(argv[++a]);
+        else if (!strcmp(argv[a], "-max-steps") && (a + 1 < argc))
+            settings.maxSteps = atoi(argv[++a]);
+        else if (!strcmp(argv[a], "-self-max") && (a + 1 < argc))
+            settings.selfMax = (GLuint)atoi(argv[++a]);
+        else {
+
+            usage(argv[0]);
+            return(1);
+        }
+    }
+
+    settings.maxSteps = glm::max(settings.maxSteps, 1);
+    settings.minSteps = glm::min(glm::max(settings.minSteps, 1), settings.maxSteps);
+
+#ifdef _OPENMP
+    GLint threads = omp_get_max_threads();
+#else
+    GLint threads = 1;
+#endif
+
+    printf("{\n");
+    printf("  \"timestep\": %g,\n", settings.timestep);
+    printf("  \"threads\": %d,\n", threads);
+    printf("  \"spring_kernel\": \"%s\",\n", SpringKernel::getName(SpringKernel::supportedISA()));
+    printf("  \"results\": [");
+
+    GLboolean first = GL_TRUE;
+
+    for (size_t s = 0; s < sizes.size(); s++) {
+        for (size_t f = 0; f < featureSet.size(); f++) {
+            for (size_t m = 0; m < methods.size(); m++) {
+
+                const GLuint size = sizes[s];
+                const Feature& feature = features[featureSet[f]];
+                const MethodName& method = methodNames[methods[m]];
+
+                const double NumP = (double)(size + 1) * (double)(size + 1);
+
+                fprintf(stderr, "%ux%u %-8s %-10s ", size, size, feature.name, method.name);
+
+                printf("%s\n    { \"method\": \"%s\", \"size\": %u, \"particles\": %.0f, \"features\": \"%s\"",
+                       first ? "" : ",", method.name, size, NumP, feature.name);
+
+                printf(", \"inverse\": %s, \"wind\": %s, \"sphere\": %s, \"planar\": %s, \"self\": %s",
+                       feature.inverseDy ? "true" : "false", feature.wind ? "true" : "false", feature.sphereCol ? "true" : "false",
+                       feature.planarCol ? "true" : "false", feature.selfCol ? "true" : "false");
+
+                first = GL_FALSE;
+
+                if (feature.selfCol && (size > settings.selfMax)) {
+
+                    fprintf(stderr, "skipped\n");
+                    printf(", \"skipped\": \"self collision above -self-max %u\" }", settings.selfMax);
+                    continue;
+                }
+
+                Result result = isolateCase(size, method.method, feature, settings);
+
+                if (!result.ok) {
+
+                    fprintf(stderr, "failed\n");
+                    printf(", \"skipped\": \"case failed\" }");
+                    continue;
+                }
+
+                const double nsPerParticleStep = (result.seconds * 1.0e9) / (result.steps * NumP);
+                const double stepsPerSecond = result.steps / result.seconds;
+
+                fprintf(stderr, "%10.2f ns/particle/step %10.1f steps/s\n", nsPerParticleStep, stepsPerSecond);
+
+                printf(", \"steps\": %d, \"seconds\": %.6f, \"ns_per_particle_step\": %.3f, \"steps_per_second\": %.3f",
+                       result.steps, result.seconds, nsPerParticleStep, stepsPerSecond);
+
+                printf(", \"setup_ms\": %.3f, \"peak_rss_kib\": %ld, \"setup_allocations\": %llu",
+                       result.setupMs, result.peakRSS, (unsigned long long)result.setupAllocations);
+
+                printf(", \"allocations_per_step\": %.2f, \"bytes_allocated_per_step\": %.0f, \"stable\": %s }",
+                       (double)result.stepAllocations / result.steps, (double)result.stepBytes / result.steps,
+                       result.stable ? "true" : "false");
+            }
+        }
+    }
+
+    printf("\n  ]\n}\n");
+
+    return(0);
+}
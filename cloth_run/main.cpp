@@ -0,0 +1,274 @@
+/// CLOTH RUN
+
+/// Headless batch runner, steps a scene for a fixed number of frames as fast as possible and reports the throughput,
+/// links only the cloth_core library, no window, GL context or GUI is created
+/// Implicit methods also report the solver iterations & residuals per step, -solver, -tol, -energy, -cold & -fixedbudget
+/// set the solver policy, see Cloth::SolverPolicy, -constraints selects the constraint pass of the dynamic inverse,
+/// long range attachments by default
+/// -adaptive splits each frame of length -t into steps sized by Cloth::advanceFrame, -atol & -maxsteps set the error
+/// tolerance of the explicit schemes & the steps allowed per frame, the steps per frame are reported
+/// -rates sets the evaluations per step of each spring type for MULTIRATE, 4,4,1 by default
+/// Built with CLOTH_PROFILING defined, the per phase timings of the last 256 frames are printed as well
+/// Usage: cloth_run [-n grid size] [-f frames] [-m method] [-t timestep] [-wind] [-sphere] [-plane] [-self] [-noinverse] [-constraints GS|JACOBI|LRA] [-solver PCCG|MGV|MGW|CHEB] [-tol tolerance] [-energy] [-cold] [-fixedbudget] [-adaptive] [-atol tolerance] [-maxsteps steps] [-rates structural,shear,bend]
+
+// OpenGL Mathematics Library
+#include <GLM/glm.hpp>
+
+// C/C++ Libraries
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Internal Dependancies
+#include "Cloth.hpp"
+
+using namespace glm;
+
+struct MethodName {
+
+    Cloth::IntegrationMethod method;
+    const char* name;
+};
+
+static const MethodName methodNames[] = {
+
+    { Cloth::F_EULER,   "F_EULER" },
+    { Cloth::B_EULER,   "B_EULER" },
+    { Cloth::MB_EULER,  "MB_EULER" },
+    { Cloth::FB_EULER,  "FB_EULER" },
+    { Cloth::MFB_EULER, "MFB_EULER" },
+    { Cloth::RK2_EULER, "RK2_EULER" },
+    { Cloth::RK4_EULER, "RK4_EULER" },
+    { Cloth::VERLET,    "VERLET" },
+    { Cloth::PROJECTIVE, "PROJECTIVE" },
+    { Cloth::XPBD,      "XPBD" },
+    { Cloth::MULTIRATE, "MULTIRATE" }
+};
+
+static const GLsizei NumMethods = sizeof(methodNames) / sizeof(methodNames[0]);
+
+static GLvoid usage(const char* program) {
+
+    fprintf(stderr, "Usage: %s [-n grid size] [-f frames] [-m method] [-t timestep] [-wind] [-sphere] [-plane] [-self] [-noinverse] [-constraints GS|JACOBI|LRA] [-solver PCCG|MGV|MGW|CHEB] [-tol tolerance] [-energy] [-cold] [-fixedbudget] [-adaptive] [-atol tolerance] [-maxsteps steps] [-rates structural,shear,bend]\n", program);
+    fprintf(stderr, "Methods:");
+
+    for (GLsizei k = 0; k < NumMethods; k++)
+        fprintf(stderr, " %s", methodNames[k].name);
+
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char** argv) {
+
+    GLuint size = 50;
+    GLsizei frames = 1000;
+    GLfloat timestep = 0.0100f;
+
+    Cloth::IntegrationMethod method = Cloth::MFB_EULER;
+
+    GLboolean wind = GL_FALSE;
+    GLboolean sphereCol = GL_FALSE;
+    GLboolean planarCol = GL_FALSE;
+    GLboolean selfCol = GL_FALSE;
+    GLboolean inverseDy = GL_TRUE;
+
+    Cloth::ConstraintSolver constraintSolver = Cloth::LONG_RANGE_ATTACHMENTS;
+
+    Cloth::SolverPolicy policy = { Cloth::PCCG, Cloth::RELATIVE_RESIDUAL, 1.0e-3f, GL_TRUE, GL_TRUE, 0 };
+    Cloth::StepPolicy stepping = { GL_FALSE, 1.0e-5f, 0.5f, 1.0e-5f, 1.0f, 64 };
+    GLuint rates[3] = { 4, 4, 1 };
+
+    for (GLint a = 1; a < argc; a++) {
+
+        if (!strcmp(argv[a], "-n") && (a + 1 < argc))
+            size = (GLuint)atoi(argv[++a]);
+        else if (!strcmp(argv[a], "-f") && (a + 1 < argc))
+            frames = atoi(argv[++a]);
+        else if (!strcmp(argv[a], "-t") && (a + 1 < argc))
+            timestep = (GLfloat)atof(argv[++a]);
+        else if (!strcmp(argv[a], "-m") && (a + 1 < argc)) {
+
+            const char* name = argv[++a];
+            GLsizei k = 0;
+
+            while ((k < NumMethods) && strcmp(methodNames[k].name, name))
+                k++;
+
+            if (k == NumMethods) {
+
+                usage(argv[0]);
+                return(1);
+            }
+
+            method = methodNames[k].method;
+        }
+        else if (!strcmp(argv[a], "-wind"))
+            wind = GL_TRUE;
+        else if (!strcmp(argv[a], "-sphere"))
+            sphereCol = GL_TRUE;
+        else if (!strcmp(argv[a], "-plane"))
+            planarCol = GL_TRUE;
+        else if (!strcmp(argv[a], "-self"))
+            selfCol = GL_TRUE;
+        else if (!strcmp(argv[a], "-noinverse"))
+            inverseDy = GL_FALSE;
+        else if (!strcmp(argv[a], "-constraints") && (a + 1 < argc)) {
+
+            const char* name = argv[++a];
+
+            if (!strcmp(name, "GS"))
+                constraintSolver = Cloth::COLOURED_GAUSS_SEIDEL;
+            else if (!strcmp(name, "JACOBI"))
+                constraintSolver = Cloth::ACCELERATED_JACOBI;
+            else if (!strcmp(name, "LRA"))
+                constraintSolver = Cloth::LONG_RANGE_ATTACHMENTS;
+            else {
+
+                usage(argv[0]);
+                return(1);
+            }
+        }
+        else if (!strcmp(argv[a], "-solver") && (a + 1 < argc)) {
+
+            const char* name = argv[++a];
+
+            if (!strcmp(name, "PCCG"))
+                policy.backend = Cloth::PCCG;
+            else if (!strcmp(name, "MGV"))
+                policy.backend = Cloth::MULTIGRID_V;
+            else if (!strcmp(name, "MGW"))
+                policy.backend = Cloth::MULTIGRID_W;
+            else if (!strcmp(name, "CHEB"))
+                policy.backend = Cloth::CHEBYSHEV_JACOBI;
+            else {
+
+                usage(argv[0]);
+                return(1);
+            }
+        }
+        else if (!strcmp(argv[a], "-tol") && (a + 1 < argc))
+            policy.tolerance = (GLfloat)atof(argv[++a]);
+        else if (!strcmp(argv[a], "-energy"))
+            policy.stopping = Cloth::ENERGY_NORM;
+        else if (!strcmp(argv[a], "-cold"))
+            policy.warmStart = GL_FALSE;
+        else if (!strcmp(argv[a], "-fixedbudget"))
+            policy.adaptiveBudget = GL_FALSE;
+        else if (!strcmp(argv[a], "-adaptive"))
+            stepping.adaptive = GL_TRUE;
+        else if (!strcmp(argv[a], "-atol") && (a + 1 < argc))
+            stepping.tolerance = (GLfloat)atof(argv[++a]);
+        else if (!strcmp(argv[a], "-maxsteps") && (a + 1 < argc))
+            stepping.maxSteps = atoi(argv[++a]);
+        else if (!strcmp(argv[a], "-rates") && (a + 1 < argc)) {
+
+            if (sscanf(argv[++a], "%u,%u,%u", &rates[0], &rates[1], &rates[2]) != 3) {
+
+                usage(argv[0]);
+                return(1);
+            }
+        }
+        else {
+
+            usage(argv[0]);
+            return(1);
+        }
+    }
+
+    // Scene matching the interactive application defaults
+    const vec3 windDirection = vec3(-0.91f, -0.17f, 0.38f) * 3.6f;
+    const vec3 sphereCentre = vec3(0, 1.0f / 2.5f, 0);
+    const GLfloat sphereRadius = 0.20f;
+
+    Cloth cloth(1.0f, 1.0f, size, size, Cloth::One);
+    cloth.setSolverPolicy(policy);
+    cloth.setStepPolicy(stepping);
+    cloth.setSpringRates(rates[0], rates[1], rates[2]);
+    cloth.setConstraintSolver(constraintSolver);
+
+    const GLboolean implicit = (method == Cloth::B_EULER) || (method == Cloth::MB_EULER);
+
+    GLsizei totalSolves = 0, totalIterations = 0, maxIterations = 0, unconverged = 0;
+    double totalResidual = 0;
+
+    GLsizei totalSteps = 0, minSteps = 0, maxSteps = 0, rejectedSteps = 0, limitedFrames = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (GLsizei f = 0; f < frames; f++) {
+
+        cloth.setStiffness(KSST, KSSH, KSBE);
+        cloth.setDamping(KDST, KDSH, KDSH, GD);
+
+        if (sphereCol)
+            cloth.sphereCollision(sphereCentre, sphereRadius);
+
+        if (planarCol)
+            cloth.planarCollision(0);
+
+        if (selfCol)
+            cloth.selfCollision();
+
+        if (wind)
+            cloth.setWind(windDirection, vec3(0));
+
+        const GLsizei steps = cloth.advanceFrame(timestep, method, inverseDy);
+        const Cloth::StepStats& stepStats = cloth.getStepStats();
+
+        totalSteps += steps;
+        minSteps = f ? glm::min(minSteps, steps) : steps;
+        maxSteps = glm::max(maxSteps, steps);
+        rejectedSteps += stepStats.rejected;
+
+        if (stepStats.limited)
+            limitedFrames++;
+
+        // Summed over every step of the frame, not only the last step's solve
+        if (implicit) {
+
+            totalSolves += stepStats.solves;
+            totalIterations += stepStats.iterations;
+            maxIterations = glm::max(maxIterations, stepStats.maxIterations);
+            totalResidual += stepStats.residual;
+            unconverged += stepStats.unconverged;
+        }
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double NumP = (double)(size + 1) * (double)(size + 1);
+
+    const char* name = methodNames[0].name;
+
+    for (GLsizei k = 0; k < NumMethods; k++) {
+        if (methodNames[k].method == method)
+            name = methodNames[k].name;
+    }
+
+    printf("%s %ux%u, %d frames in %.3f s\n", name, size, size, frames, seconds);
+    printf("%.1f steps/s, %.2f ns/particle/step\n", totalSteps / seconds, (seconds * 1.0e9) / (totalSteps * NumP));
+
+    if (stepping.adaptive && frames)
+        printf("adaptive: %.2f steps/frame (min %d, max %d), %d rejected, %d frames over tolerance or budget\n",
+               (double)totalSteps / frames, minSteps, maxSteps, rejectedSteps, limitedFrames);
+
+    if (implicit && totalSolves)
+        printf("solver: %.2f iterations/step (max %d), mean residual %.3g, %d unconverged steps\n",
+               (double)totalIterations / totalSolves, maxIterations, totalResidual / totalSolves, unconverged);
+
+#ifdef CLOTH_PROFILING
+    printf("\n%-20s %10s %12s %12s %12s\n", "Phase (us/frame)", "calls", "min", "mean", "p99");
+
+    for (GLsizei p = 0; p < PROFILE_PHASES; p++) {
+
+        ProfileStats stats = cloth.getProfileStats((ProfilePhase)p);
+
+        if (stats.frames)
+            printf("%-20s %10.1f %12.2f %12.2f %12.2f\n", Profiler::getName((ProfilePhase)p), stats.calls, stats.min, stats.mean, stats.p99);
+    }
+#endif
+
+    return(0);
+}